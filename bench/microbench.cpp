@@ -0,0 +1,419 @@
+// Microbenchmarks das rotinas de CPU mais executadas pelo jogo: testes e
+// respostas de colisão, funções de "matrices.h" e o processamento das
+// malhas (ComputeNormals() e BuildMeshData(), a parte de CPU de
+// BuildTrianglesAndAddToVirtualScene()) sobre os arquivos ".obj" do jogo.
+//
+// Compilado como o alvo "microbench" do CMake. Para números representativos,
+// configure com -DCMAKE_BUILD_TYPE=Release. Uso (a partir de bin/Linux, como
+// o executável principal):
+//
+//     ./microbench [--filter TEXTO] [--output ARQUIVO.json] [--data DIRETÓRIO]
+//
+// Cada benchmark é repetido MICROBENCH_SAMPLES vezes; em cada amostra, a
+// rotina é executada em laço por pelo menos MICROBENCH_MIN_SAMPLE_TIME
+// segundos. Os resultados (mediana e mínimo do tempo por operação) são
+// escritos em JSON, para acompanhar regressões entre versões.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "matrices.h"
+#include "collisions.h"
+#include "mesh.h"
+#include "simulation.h"
+
+#ifndef MICROBENCH_BUILD_TYPE
+#define MICROBENCH_BUILD_TYPE "unknown"
+#endif
+
+#define MICROBENCH_SAMPLES          5
+#define MICROBENCH_MIN_SAMPLE_TIME  0.1
+
+// Resultado de um benchmark
+struct BenchmarkResult
+{
+    std::string name;
+    double      ops_per_sample;
+    double      median_ns;  // Mediana do tempo por operação, em nanossegundos
+    double      min_ns;     // Menor tempo por operação
+};
+
+// Acumula os resultados das rotinas medidas, para que o compilador não as
+// descarte como código sem efeito.
+volatile float g_Sink = 0.0f;
+
+std::vector<BenchmarkResult> g_Results;
+const char* g_Filter = NULL;
+
+static double Now()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Mede "run", que executa "ops" operações por chamada. Se "setup" não for
+// vazia, ela é chamada antes de cada chamada de "run", fora da medição (por
+// exemplo, para copiar os dados que "run" modifica).
+static void Benchmark(const std::string& name, double ops, const std::function<void()>& setup, const std::function<void()>& run)
+{
+    if ( g_Filter != NULL && name.find(g_Filter) == std::string::npos )
+        return;
+
+    // Tempo de "calls" chamadas de "run", em segundos
+    auto measure = [&](size_t calls) {
+        if ( !setup )
+        {
+            double start = Now();
+            for (size_t i = 0; i < calls; ++i)
+                run();
+            return Now() - start;
+        }
+
+        double elapsed = 0.0;
+        for (size_t i = 0; i < calls; ++i)
+        {
+            setup();
+            double start = Now();
+            run();
+            elapsed += Now() - start;
+        }
+        return elapsed;
+    };
+
+    // Calibração: número de chamadas por amostra
+    size_t calls = 1;
+    while ( true )
+    {
+        double elapsed = measure(calls);
+        if ( elapsed >= MICROBENCH_MIN_SAMPLE_TIME || calls >= ((size_t)1 << 30) )
+            break;
+        calls *= elapsed > 0.0 ? std::max(2.0, std::min(100.0, 1.2 * MICROBENCH_MIN_SAMPLE_TIME / elapsed)) : 100.0;
+    }
+
+    std::vector<double> samples;
+    for (int s = 0; s < MICROBENCH_SAMPLES; ++s)
+        samples.push_back(measure(calls) * 1e9 / (calls * ops));
+    std::sort(samples.begin(), samples.end());
+
+    BenchmarkResult result;
+    result.name           = name;
+    result.ops_per_sample = calls * ops;
+    result.median_ns      = samples[samples.size() / 2];
+    result.min_ns         = samples.front();
+    g_Results.push_back(result);
+
+    printf("%-44s %12.2f ns/op (min %.2f)\n", name.c_str(), result.median_ns, result.min_ns);
+}
+
+static void Benchmark(const std::string& name, double ops, const std::function<void()>& run)
+{
+    Benchmark(name, ops, std::function<void()>(), run);
+}
+
+// Gerador pseudo-aleatório fixo, para que todas as execuções usem os mesmos dados
+static uint32_t g_RandomState = 12345;
+static float RandomFloat(float lo, float hi)
+{
+    g_RandomState = g_RandomState * 1664525u + 1013904223u;
+    return lo + (hi - lo) * ((g_RandomState >> 8) * (1.0f / 16777216.0f));
+}
+
+static BoundingBox RandomBox(float range, float max_size)
+{
+    BoundingBox box;
+    box.min = glm::vec3(RandomFloat(-range, range), RandomFloat(-1.0f, 1.0f), RandomFloat(-range, range));
+    box.max = box.min + glm::vec3(RandomFloat(0.1f, max_size), RandomFloat(0.1f, max_size), RandomFloat(0.1f, max_size));
+    return box;
+}
+
+static void CollisionBenchmarks(const std::string& data_dir)
+{
+    // Pares de caixas com cerca de metade colidindo
+    const size_t NUM_BOXES = 1024;
+    std::vector<BoundingBox> boxes_a, boxes_b;
+    BoundingBoxArray box_array;
+    for (size_t i = 0; i < NUM_BOXES; ++i)
+    {
+        boxes_a.push_back(RandomBox(3.0f, 2.0f));
+        boxes_b.push_back(RandomBox(3.0f, 2.0f));
+        AppendBoundingBox(&box_array, boxes_b.back());
+    }
+
+    Benchmark("CheckAABBCollision", NUM_BOXES, [&]() {
+        int hits = 0;
+        for (size_t i = 0; i < NUM_BOXES; ++i)
+            hits += CheckAABBCollision(boxes_a[i], boxes_b[i]);
+        g_Sink = g_Sink + hits;
+    });
+
+    Benchmark("CheckAABBCollisionBatch (per box)", NUM_BOXES, [&]() {
+        uint32_t hits = 0;
+        for (size_t i = 0; i < NUM_BOXES; i += AABB_BATCH_SIZE)
+            hits ^= CheckAABBCollisionBatch(boxes_a[i], box_array, i, AABB_BATCH_SIZE);
+        g_Sink = g_Sink + hits;
+    });
+
+    // Guard rails e carro com as AABBs reais dos modelos, como na pista
+    MeshData guardRail_mesh, car_mesh;
+    LoadMeshData((data_dir + "/guardRail.obj").c_str(), &guardRail_mesh);
+    LoadMeshData((data_dir + "/car.obj").c_str(), &car_mesh);
+
+    glm::vec3 guardRail_min(0.0f), guardRail_max(0.0f), car_min(0.0f), car_max(0.0f);
+    for (size_t i = 0; i < guardRail_mesh.shapes.size(); ++i)
+    {
+        if ( guardRail_mesh.shapes[i].name == "the_guardRail" )
+        {
+            guardRail_min = guardRail_mesh.shapes[i].bbox_min;
+            guardRail_max = guardRail_mesh.shapes[i].bbox_max;
+        }
+    }
+    for (size_t i = 0; i < car_mesh.shapes.size(); ++i)
+    {
+        if ( car_mesh.shapes[i].name == "the_car" )
+        {
+            car_min = car_mesh.shapes[i].bbox_min;
+            car_max = car_mesh.shapes[i].bbox_max;
+        }
+    }
+
+    std::vector<glm::vec3> guardRail_positions = Simulation_GuardRailPositions();
+    StaticColliderGrid guardRail_grid;
+    BuildStaticColliderGrid(&guardRail_grid, guardRail_positions, guardRail_min, guardRail_max,
+                            glm::vec3(GUARDRAIL_SCALE), 8.0f);
+
+    // Posições do carro ao longo da pista, algumas encostadas nos guard rails
+    const size_t NUM_CARS = 256;
+    std::vector<glm::vec4> car_positions;
+    for (size_t i = 0; i < NUM_CARS; ++i)
+        car_positions.push_back(glm::vec4(RandomFloat(-5.5f, 5.5f), 0.5f, RandomFloat(-320.0f, 400.0f), 1.0f));
+
+    char name[128];
+    snprintf(name, sizeof(name), "ResolveCarWallCollision (%d guard rails)", (int)guardRail_positions.size());
+    Benchmark(name, NUM_CARS, [&]() {
+        for (size_t i = 0; i < NUM_CARS; ++i)
+        {
+            glm::vec4 car_pos = car_positions[i];
+            float speed = 10.0f;
+            ResolveCarWallCollision(car_pos, car_positions[i] - glm::vec4(0.0f, 0.0f, 0.1f, 0.0f),
+                                    car_min, car_max, speed, guardRail_positions,
+                                    guardRail_min, guardRail_max, glm::vec3(GUARDRAIL_SCALE));
+            g_Sink = g_Sink + car_pos.x;
+        }
+    });
+
+    snprintf(name, sizeof(name), "ResolveCarStaticCollision (%d guard rails)", (int)guardRail_positions.size());
+    Benchmark(name, NUM_CARS, [&]() {
+        for (size_t i = 0; i < NUM_CARS; ++i)
+        {
+            glm::vec4 car_pos = car_positions[i];
+            float speed = 10.0f;
+            ResolveCarStaticCollision(car_pos, 0.3f, car_min, car_max, speed, guardRail_grid);
+            g_Sink = g_Sink + car_pos.x;
+        }
+    });
+
+    Benchmark("SweepCarStaticColliders", NUM_CARS, [&]() {
+        for (size_t i = 0; i < NUM_CARS; ++i)
+        {
+            float toi = 1.0f;
+            glm::vec3 normal;
+            SweepCarStaticColliders(car_positions[i], car_positions[i] + glm::vec4(0.3f, 0.0f, 0.4f, 0.0f), 0.3f,
+                                    car_min, car_max, guardRail_grid, &toi, &normal);
+            g_Sink = g_Sink + toi;
+        }
+    });
+
+    // Pares de carros próximos, cerca de metade colidindo
+    std::vector<glm::vec4> sphere_a, sphere_b;
+    for (size_t i = 0; i < NUM_BOXES; ++i)
+    {
+        sphere_a.push_back(glm::vec4(RandomFloat(-2.0f, 2.0f), 0.5f, RandomFloat(-2.0f, 2.0f), 1.0f));
+        sphere_b.push_back(glm::vec4(RandomFloat(-2.0f, 2.0f), 0.5f, RandomFloat(-2.0f, 2.0f), 1.0f));
+    }
+
+    Benchmark("ResolveSphereCollision", NUM_BOXES, [&]() {
+        for (size_t i = 0; i < NUM_BOXES; ++i)
+        {
+            glm::vec4 a = sphere_a[i], b = sphere_b[i];
+            float speed_a = 10.0f, speed_b = 10.0f;
+            ResolveSphereCollision(a, 1.0f, speed_a, b, 1.0f, speed_b);
+            g_Sink = g_Sink + a.x + b.z;
+        }
+    });
+}
+
+static void MatrixBenchmarks()
+{
+    const size_t NUM_MATRICES = 1024;
+    std::vector<glm::vec4> params;
+    for (size_t i = 0; i < NUM_MATRICES; ++i)
+        params.push_back(glm::vec4(RandomFloat(-10.0f, 10.0f), RandomFloat(-10.0f, 10.0f),
+                                   RandomFloat(-10.0f, 10.0f), RandomFloat(-3.14f, 3.14f)));
+
+    Benchmark("Matrix_Translate*Rotate_Y*Scale", NUM_MATRICES, [&]() {
+        float sum = 0.0f;
+        for (size_t i = 0; i < NUM_MATRICES; ++i)
+        {
+            const glm::vec4& p = params[i];
+            glm::mat4 m = Matrix_Translate(p.x, p.y, p.z) * Matrix_Rotate_Y(p.w) * Matrix_Scale(0.8f, 0.8f, 0.8f);
+            sum += m[3][0];
+        }
+        g_Sink = g_Sink + sum;
+    });
+
+    Benchmark("Matrix_Rotate", NUM_MATRICES, [&]() {
+        float sum = 0.0f;
+        for (size_t i = 0; i < NUM_MATRICES; ++i)
+        {
+            const glm::vec4& p = params[i];
+            glm::mat4 m = Matrix_Rotate(p.w, glm::vec4(p.x, p.y, p.z + 11.0f, 0.0f));
+            sum += m[1][2];
+        }
+        g_Sink = g_Sink + sum;
+    });
+
+    Benchmark("Matrix_Camera_View", NUM_MATRICES, [&]() {
+        float sum = 0.0f;
+        for (size_t i = 0; i < NUM_MATRICES; ++i)
+        {
+            const glm::vec4& p = params[i];
+            glm::mat4 m = Matrix_Camera_View(glm::vec4(p.x, p.y, p.z, 1.0f),
+                                             glm::vec4(1.0f, p.w, 1.0f, 0.0f),
+                                             glm::vec4(0.0f, 1.0f, 0.0f, 0.0f));
+            sum += m[3][2];
+        }
+        g_Sink = g_Sink + sum;
+    });
+
+    Benchmark("Matrix_Perspective", NUM_MATRICES, [&]() {
+        float sum = 0.0f;
+        for (size_t i = 0; i < NUM_MATRICES; ++i)
+        {
+            glm::mat4 m = Matrix_Perspective(1.0f + params[i].w * 0.1f, 4.0f / 3.0f, -0.1f, -100.0f);
+            sum += m[2][2];
+        }
+        g_Sink = g_Sink + sum;
+    });
+}
+
+static void MeshBenchmarks(const std::string& data_dir)
+{
+    // Mesmos modelos carregados pelo jogo. Os modelos sem normais no arquivo
+    // são os que passam por ComputeNormals() no carregamento.
+    const char* files[] = { "track.obj", "car.obj", "wall.obj", "arcos.obj",
+                            "guardRail.obj", "car_pc.obj", "people.obj" };
+
+    for (size_t f = 0; f < sizeof(files) / sizeof(files[0]); ++f)
+    {
+        std::string filename = data_dir + "/" + files[f];
+        float scale = strcmp(files[f], "track.obj") == 0 ? TRACK_PLANE_SCALE : 1.0f;
+
+        ObjModel* source;
+        try
+        {
+            source = new ObjModel(filename.c_str());
+        }
+        catch (const std::exception& e)
+        {
+            fprintf(stderr, "WARNING: Skipping \"%s\": %s\n", filename.c_str(), e.what());
+            continue;
+        }
+        if ( scale != 1.0f )
+            ScalePlaneModelAndTexCoords(source, scale);
+
+        // ComputeNormals() só trabalha quando o modelo não tem normais;
+        // medimos sempre sobre uma cópia sem elas.
+        ObjModel without_normals = *source;
+        without_normals.attrib.normals.clear();
+
+        // As cópias são feitas fora da medição; só a rotina é medida.
+        ObjModel model = without_normals;
+        Benchmark(std::string("ComputeNormals/") + files[f], 1, [&]() {
+            model = without_normals;
+        }, [&]() {
+            ComputeNormals(&model);
+            g_Sink = g_Sink + model.attrib.normals.size();
+        });
+
+        ObjModel with_normals = *source;
+        ComputeNormals(&with_normals);
+
+        Benchmark(std::string("BuildMeshData/") + files[f], 1, [&]() {
+            model = with_normals;
+        }, [&]() {
+            MeshData mesh;
+            BuildMeshData(&model, &mesh);
+            g_Sink = g_Sink + mesh.indices.size();
+        });
+
+        delete source;
+    }
+}
+
+static bool WriteResults(const char* filename)
+{
+    FILE* file = fopen(filename, "w");
+    if ( file == NULL )
+    {
+        fprintf(stderr, "ERROR: Cannot write \"%s\".\n", filename);
+        return false;
+    }
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"build_type\": \"%s\",\n", MICROBENCH_BUILD_TYPE);
+    fprintf(file, "  \"samples\": %d,\n", MICROBENCH_SAMPLES);
+    fprintf(file, "  \"benchmarks\": [\n");
+    for (size_t i = 0; i < g_Results.size(); ++i)
+    {
+        const BenchmarkResult& r = g_Results[i];
+        fprintf(file, "    { \"name\": \"%s\", \"ops\": %.0f, \"median_ns\": %.3f, \"min_ns\": %.3f }%s\n",
+                r.name.c_str(), r.ops_per_sample, r.median_ns, r.min_ns,
+                i + 1 < g_Results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n");
+    fprintf(file, "}\n");
+
+    if ( fclose(file) != 0 )
+    {
+        fprintf(stderr, "ERROR: Cannot write \"%s\".\n", filename);
+        return false;
+    }
+    printf("Resultados em \"%s\".\n", filename);
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    const char* output = "microbench.json";
+    std::string data_dir = "../data";
+
+    for (int i = 1; i < argc; ++i)
+    {
+        bool has_value = i + 1 < argc;
+        if ( strcmp(argv[i], "--filter") == 0 && has_value )
+            g_Filter = argv[++i];
+        else if ( strcmp(argv[i], "--output") == 0 && has_value )
+            output = argv[++i];
+        else if ( strcmp(argv[i], "--data") == 0 && has_value )
+            data_dir = argv[++i];
+        else
+        {
+            fprintf(stderr, "Usage: %s [--filter TEXT] [--output FILE.json] [--data DIR]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    CollisionBenchmarks(data_dir);
+    MatrixBenchmarks();
+    MeshBenchmarks(data_dir);
+
+    return WriteResults(output) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
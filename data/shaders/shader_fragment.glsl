@@ -16,13 +16,18 @@ in vec2 texcoords;
 // Cor interpolada pelos vértices. Para usar no modelo de Gouraud.
 in vec3 vertex_color;
 
-// Matrizes computadas no código C++ e enviadas para a GPU
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform int object_id;
+// Valores comuns a todos os desenhos de um quadro, computados no código C++
+// e enviados uma única vez por quadro para um "uniform buffer" compartilhado
+// por todas as variantes destes shaders (veja FrameUniforms em main.cpp).
+layout(std140) uniform FrameUniforms
+{
+    // Posição da câmera no sistema de coordenadas global
+    vec4 camera_position;
+};
 
-// Identificador de qual objeto está sendo desenhado
+// Identificadores dos objetos. OBJECT_ID, definido no código C++ para cada
+// variante destes shaders, indica qual objeto a variante desenha (veja
+// "shader_vertex.glsl").
 #define TRACK   0
 #define CAR     1
 #define WALL    2
@@ -55,11 +60,6 @@ out vec4 color;
 
 void main()
 {
-    // Obtemos a posição da câmera utilizando a inversa da matriz que define o
-    // sistema de coordenadas da câmera.
-    vec4 origin = vec4(0.0, 0.0, 0.0, 1.0);
-    vec4 camera_position = inverse(view) * origin;
-
     // O fragmento atual é coberto por um ponto que percente à superfície de um
     // dos objetos virtuais da cena. Este ponto, p, possui uma posição no
     // sistema de coordenadas global (World coordinates). Esta posição é obtida
@@ -89,16 +89,7 @@ void main()
     vec3 Ks;  // Especular
     float Ns; // Brilho especular (shininess)
 
-    // Coordenadas de textura do plano, obtidas do arquivo OBJ.
-        if (object_id == 0 || object_id == 1 || object_id == 2 ||
-            object_id == 4 || object_id == 5 || object_id == 6 ||
-            object_id == 7 || object_id == 8 || object_id == 9)
-    {
-        U = texcoords.x;
-        V = texcoords.y;
-    }
-
-        if (object_id == 3) // ARCS como toro
+#if OBJECT_ID == ARCS // ARCS como toro
     {
         vec3 pos = position_model.xyz;
 
@@ -123,68 +114,65 @@ void main()
         float U = (theta + M_PI) / (2.0 * M_PI);
         float V = (phi + M_PI) / (2.0 * M_PI);
     }
-
-    if (object_id == 0) { // TRACK
-        Kd = texture(TextureImage0, vec2(U,V)).rgb;
-        Ka = vec3(0.05f, 0.05f, 0.05f);
-        Ks = vec3(0.1f, 0.1f, 0.1f);
-        Ns = 8.0f;
-    } else if (object_id == 1) { // CAR
-        Kd = texture(TextureImage1, vec2(U,V)).rgb;
-        Ka = Kd * 0.5f;
-        Ks = vec3(0.8f, 0.8f, 0.8f);
-        Ns = 64.0f;
-    } else if (object_id == 2) { 
-        Kd = texture(TextureImage2, vec2(U,V)).rgb;
-        Ka = Kd * 0.5f;
-        Ks = vec3(0.8f, 0.8f, 0.8f);
-        Ns = 64.0f;
-    } else if (object_id == 7) { // PLR2
-        Kd = texture(TextureImage7, vec2(U,V)).rgb;
-        Ka = Kd * 0.5f;
-        Ks = vec3(0.8f, 0.8f, 0.8f);
-        Ns = 64.0f;
-    } else if (object_id == 3) { // ARCS
-        Kd = texture(TextureImage3, vec2(U,V)).rgb;
-        Ka = Kd * 0.5f;
-        Ks = vec3(0.1f, 0.1f, 0.1f);
-        Ns = 35.0f;
-    } else if (object_id == 4) { // GUARD
-        Kd = texture(TextureImage4, vec2(U,V)).rgb;
-        Ka = Kd * 0.5f;
-        Ks = vec3(0.1f, 0.1f, 0.1f);
-        Ns = 35.0f;
-    } else if (object_id == 5) {
-        Kd = texture(TextureImage5, vec2(U,V)).rgb;
-        Ka = Kd * 0.5f;
-        Ks = vec3(0.1f, 0.1f, 0.1f);
-        Ns = 35.0f;
-    } else if (object_id == 6) {
-        Kd = texture(TextureImage6, vec2(U,V)).rgb;
-        Ka = Kd * 0.5f;
-        Ks = vec3(0.1f, 0.1f, 0.1f);
-        Ns = 35.0f;
-    } else if (object_id == 7) {
-        Kd = texture(TextureImage7, vec2(U,V)).rgb;
-        Ka = vec3(0.05f, 0.05f, 0.05f);
-        Ks = vec3(0.8f, 0.8f, 0.8f);
-        Ns = 45.0f;
-    } else if (object_id == 8) { 
-        Kd = texture(TextureImage8, vec2(U,V)).rgb;
-        Ka = Kd * 0.5f;
-        Ks = vec3(0.1f, 0.1f, 0.1f);
-        Ns = 35.0f;
-    } else if (object_id == 9) { 
-        Kd = texture(TextureImage9, vec2(U,V)).rgb;
-        Ka = Kd * 0.5f;
-        Ks = vec3(0.1f, 0.1f, 0.1f);
-        Ns = 35.0f;
-    } else {
-        Kd = vec3(0.698039f, 0.698039f, 0.698039f);
-        Ka = vec3(0.0f, 0.0f, 0.0f);
-        Ks = vec3(0.0f, 0.0f, 0.0f);
-        Ns = 1.0f;
-    }
+#endif
+
+    // Material de cada objeto
+#if OBJECT_ID == TRACK
+    Kd = texture(TextureImage0, vec2(U,V)).rgb;
+    Ka = vec3(0.05f, 0.05f, 0.05f);
+    Ks = vec3(0.1f, 0.1f, 0.1f);
+    Ns = 8.0f;
+#elif OBJECT_ID == CAR
+    Kd = texture(TextureImage1, vec2(U,V)).rgb;
+    Ka = Kd * 0.5f;
+    Ks = vec3(0.8f, 0.8f, 0.8f);
+    Ns = 64.0f;
+#elif OBJECT_ID == WALL
+    Kd = texture(TextureImage2, vec2(U,V)).rgb;
+    Ka = Kd * 0.5f;
+    Ks = vec3(0.8f, 0.8f, 0.8f);
+    Ns = 64.0f;
+#elif OBJECT_ID == PC // PLR2
+    Kd = texture(TextureImage7, vec2(U,V)).rgb;
+    Ka = Kd * 0.5f;
+    Ks = vec3(0.8f, 0.8f, 0.8f);
+    Ns = 64.0f;
+#elif OBJECT_ID == ARCS
+    Kd = texture(TextureImage3, vec2(U,V)).rgb;
+    Ka = Kd * 0.5f;
+    Ks = vec3(0.1f, 0.1f, 0.1f);
+    Ns = 35.0f;
+#elif OBJECT_ID == GUARD
+    Kd = texture(TextureImage4, vec2(U,V)).rgb;
+    Ka = Kd * 0.5f;
+    Ks = vec3(0.1f, 0.1f, 0.1f);
+    Ns = 35.0f;
+#elif OBJECT_ID == WHEEL
+    Kd = texture(TextureImage5, vec2(U,V)).rgb;
+    Ka = Kd * 0.5f;
+    Ks = vec3(0.1f, 0.1f, 0.1f);
+    Ns = 35.0f;
+#elif OBJECT_ID == WINDOW
+    Kd = texture(TextureImage6, vec2(U,V)).rgb;
+    Ka = Kd * 0.5f;
+    Ks = vec3(0.1f, 0.1f, 0.1f);
+    Ns = 35.0f;
+#elif OBJECT_ID == PEOPLE
+    Kd = texture(TextureImage8, vec2(U,V)).rgb;
+    Ka = Kd * 0.5f;
+    Ks = vec3(0.1f, 0.1f, 0.1f);
+    Ns = 35.0f;
+#elif OBJECT_ID == GRANDMA
+    Kd = texture(TextureImage9, vec2(U,V)).rgb;
+    Ka = Kd * 0.5f;
+    Ks = vec3(0.1f, 0.1f, 0.1f);
+    Ns = 35.0f;
+#else
+    Kd = vec3(0.698039f, 0.698039f, 0.698039f);
+    Ka = vec3(0.0f, 0.0f, 0.0f);
+    Ks = vec3(0.0f, 0.0f, 0.0f);
+    Ns = 1.0f;
+#endif
 
         // Fonte de iluminação, espectro da luz ambiente e equação da iluminação
         vec3 I = vec3(0.96f, 1.00f, 0.91f);
@@ -1,17 +1,31 @@
 #version 330 core
 
 // Atributos de vértice recebidos como entrada ("in") pelo Vertex Shader.
-// Veja a função BuildTrianglesAndAddToVirtualScene() em "main.cpp".
-layout (location = 0) in vec4 model_coefficients;
-layout (location = 1) in vec4 normal_coefficients;
+// Veja a função BuildTrianglesAndAddToVirtualScene() em "main.cpp" e a
+// estrutura PackedVertex em "mesh.h".
+layout (location = 0) in vec3 position_unorm;       // Posição em [0,1]^3 dentro da bbox do objeto
+layout (location = 1) in vec2 normal_octahedral;    // Normal octaédrica (snorm16 sem normalizar)
 layout (location = 2) in vec2 texture_coefficients;
 
-// Matrizes computadas no código C++ e enviadas para a GPU
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-
-// Identificador de qual objeto está sendo desenhado
+// Matriz de modelagem de cada instância (locations 3 a 6). Fora do desenho
+// instanciado vale a identidade. Veja "instancing.h".
+layout (location = 3) in mat4 instance_model;
+
+// Matrizes computadas no código C++ e enviadas para a GPU. As inversas e os
+// produtos que não dependem do vértice são feitos uma única vez por desenho
+// na CPU; veja SetModelMatrix() em "main.cpp".
+uniform mat4 model;                 // Modelagem do objeto
+uniform mat4 model_view_projection; // projection * view * model
+uniform mat3 normal_matrix;         // inverse(transpose(model)), 3x3
+
+// Axis-Aligned Bounding Box do objeto, utilizada para decodificar as posições
+uniform vec4 bbox_min;
+uniform vec4 bbox_max;
+
+// Identificadores dos objetos. Cada objeto é desenhado com uma variante
+// própria destes shaders, compilada com "#define OBJECT_ID <identificador>"
+// (veja LoadShadersFromFiles() em "main.cpp"), então o código específico de
+// cada objeto é escolhido pelo pré-processador, e não em tempo de execução.
 #define TRACK   0
 #define CAR     1
 #define WALL    2
@@ -23,8 +37,6 @@ uniform mat4 projection;
 #define PEOPLE  8
 #define GRANDMA 9
 
-uniform int object_id;
-
 // Variáveis para acesso das imagens de textura
 uniform sampler2D TextureImage0;
 uniform sampler2D TextureImage1;
@@ -46,8 +58,27 @@ out vec4 normal;
 out vec2 texcoords;
 out vec3 vertex_color;
 
+// Decodifica uma normal em codificação octaédrica. Veja
+// EncodeOctahedralNormal() em "mesh.cpp".
+vec3 DecodeOctahedralNormal(vec2 e)
+{
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += (n.x >= 0.0) ? -t : t;
+    n.y += (n.y >= 0.0) ? -t : t;
+    return normalize(n);
+}
+
 void main()
 {
+    // Reconstruímos os atributos do vértice a partir do formato compacto
+    vec4 model_coefficients  = vec4(mix(bbox_min.xyz, bbox_max.xyz, position_unorm), 1.0);
+    vec4 normal_coefficients = vec4(DecodeOctahedralNormal(max(normal_octahedral / 32767.0, -1.0)), 0.0);
+
+    // Posição do vértice no sistema de coordenadas do objeto, após a
+    // modelagem da instância
+    vec4 instance_coefficients = instance_model * model_coefficients;
+
     // A variável gl_Position define a posição final de cada vértice
     // OBRIGATORIAMENTE em "normalized device coordinates" (NDC), onde cada
     // coeficiente estará entre -1 e 1 após divisão por w.
@@ -60,7 +91,7 @@ void main()
     // deste Vertex Shader, a placa de vídeo (GPU) fará a divisão por W. Veja
     // slides 41-67 e 69-86 do documento Aula_09_Projecoes.pdf.
 
-    gl_Position = projection * view * model * model_coefficients;
+    gl_Position = model_view_projection * instance_coefficients;
 
     // Como as variáveis acima  (tipo vec4) são vetores com 4 coeficientes,
     // também é possível acessar e modificar cada coeficiente de maneira
@@ -77,15 +108,18 @@ void main()
     // rasterizador para gerar atributos únicos para cada fragmento gerado.
 
     // Posição do vértice atual no sistema de coordenadas global (World).
-    position_world = model * model_coefficients;
+    position_world = model * instance_coefficients;
 
     // Posição do vértice atual no sistema de coordenadas local do modelo.
     position_model = model_coefficients;
 
     // Normal do vértice atual no sistema de coordenadas global (World).
     // Veja slides 123-151 do documento Aula_07_Transformacoes_Geometricas_3D.pdf.
-    normal = inverse(transpose(model)) * normal_coefficients;
-    normal.w = 0.0;
+    // As matrizes de instância são somente rotação, escala uniforme e
+    // translação, então a sua parte 3x3 transforma as normais corretamente a
+    // menos do comprimento, que é corrigido pelo normalize() do Fragment
+    // Shader (veja "instancing.h").
+    normal = vec4(normal_matrix * (mat3(instance_model) * normal_coefficients.xyz), 0.0);
 
     // Coordenadas de textura obtidas do arquivo OBJ (se existirem!)
     texcoords = texture_coefficients;
@@ -93,31 +127,31 @@ void main()
     vertex_color = vec3(0.0f, 0.0f, 0.0f);
 
     // Objetos que utilizarão modelo de interpolação por vértices
-    if (object_id == 1) { // CAR
-        // Normal do fragmento atual, interpolada pelo rasterizador a partir das
-        // normais de cada vértice.
-        vec4 n = normalize(normal);
+#if OBJECT_ID == CAR
+    // Normal do fragmento atual, interpolada pelo rasterizador a partir das
+    // normais de cada vértice.
+    vec4 n = normalize(normal);
 
-        // Vetor que define o sentido da fonte de luz em relação ao ponto atual.
-        vec4 l = normalize(vec4(1.0,1.0,0.0,0.0));
+    // Vetor que define o sentido da fonte de luz em relação ao ponto atual.
+    vec4 l = normalize(vec4(1.0,1.0,0.0,0.0));
 
-        // Coordenadas de textura U e V
-        float U = texcoords.x;
-        float V = texcoords.y;
+    // Coordenadas de textura U e V
+    float U = texcoords.x;
+    float V = texcoords.y;
 
-        vec3 Kd = texture(TextureImage1, vec2(U,V)).rgb;
-        vec3 Ka = Kd * 0.1f;
+    vec3 Kd = texture(TextureImage1, vec2(U,V)).rgb;
+    vec3 Ka = Kd * 0.1f;
 
-        // Espectro da fonte de iluminação
-        vec3 I = vec3(0.98f, 1.00f, 0.92f);
+    // Espectro da fonte de iluminação
+    vec3 I = vec3(0.98f, 1.00f, 0.92f);
 
-        // Espectro da luz ambiente
-        vec3 Ia = vec3(0.32f, 0.69f, 0.55f);
+    // Espectro da luz ambiente
+    vec3 Ia = vec3(0.32f, 0.69f, 0.55f);
 
-        // Equação de Iluminação
-        vec3 lambert_diffuse_term = Kd * I * max(0, dot(n, l));
-        vec3 ambient_term = Ka * Ia;
+    // Equação de Iluminação
+    vec3 lambert_diffuse_term = Kd * I * max(0, dot(n, l));
+    vec3 ambient_term = Ka * Ia;
 
-        vertex_color = lambert_diffuse_term + ambient_term;
-    }
+    vertex_color = lambert_diffuse_term + ambient_term;
+#endif
 }
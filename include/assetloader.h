@@ -0,0 +1,79 @@
+// assetloader.h
+
+#ifndef ASSETLOADER_H
+#define ASSETLOADER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mesh.h"
+
+// Imagem de textura já decodificada (RGB, 8 bits por canal), pronta para ser
+// enviada para a GPU com glTexImage2D().
+struct LoadedImage
+{
+    std::string    filename;
+    unsigned char* data;     // NULL se a leitura falhou
+    int            width;
+    int            height;
+};
+
+// Malha lida de um arquivo ".obj" (ou do seu cache binário), pronta para ser
+// enviada para a GPU com BuildTrianglesAndAddToVirtualScene().
+struct LoadedMesh
+{
+    std::string filename;
+    float       scale;
+    MeshData    mesh;
+    std::string error;  // Mensagem de erro, vazia se a leitura foi bem sucedida
+};
+
+// Carregador de recursos em paralelo. Os arquivos ".obj" e as imagens são
+// lidos e decodificados por um conjunto de threads de trabalho; somente a
+// thread que possui o contexto OpenGL faz o envio para a GPU, percorrendo os
+// resultados em Wait(). Os resultados ficam na mesma ordem em que foram
+// pedidos, de forma que as unidades de textura e os nomes dos objetos da cena
+// são os mesmos que seriam obtidos carregando tudo sequencialmente.
+struct AssetLoader
+{
+    // num_threads == 0 utiliza o número de núcleos da máquina.
+    explicit AssetLoader(unsigned int num_threads = 0);
+    ~AssetLoader();
+
+    // Enfileiram a leitura de um arquivo. Podem ser chamadas a qualquer
+    // momento antes de Wait().
+    void AddMesh(const char* filename, float scale = 1.0f);
+    void AddImage(const char* filename);
+
+    // Aguarda o término de todas as leituras pendentes.
+    void Wait();
+
+    // Libera a memória das imagens decodificadas (após o envio para a GPU).
+    void FreeImages();
+
+    // Resultados, na ordem em que foram pedidos. Só devem ser acessados após Wait().
+    std::deque<LoadedMesh>  meshes;
+    std::deque<LoadedImage> images;
+
+private:
+    AssetLoader(const AssetLoader&);
+    AssetLoader& operator=(const AssetLoader&);
+
+    void Enqueue(const std::function<void()>& job);
+    void WorkerLoop();
+
+    std::vector<std::thread>          workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex                        mutex;
+    std::condition_variable           job_available;
+    std::condition_variable           all_done;
+    size_t                            pending;
+    bool                              stopping;
+};
+
+#endif // ASSETLOADER_H
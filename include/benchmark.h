@@ -0,0 +1,61 @@
+// benchmark.h
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <vector>
+
+// Modo de benchmark: a corrida é renderizada por um número fixo de quadros,
+// com passo de tempo fixo por quadro, dificuldade escolhida automaticamente,
+// o carro do jogador acelerando (ou seguindo um replay) e a câmera
+// percorrendo um caminho fixo. Assim, todas as execuções renderizam
+// exatamente as mesmas imagens e os tempos podem ser comparados entre
+// versões do código e entre máquinas. Uso:
+//
+//     main --benchmark [--frames N] [--output ARQUIVO.json] [--replay ARQUIVO]
+//
+// Ao final, os tempos de quadro (mínimo, médio, p99 e máximo) e o tempo de
+// CPU de cada etapa do quadro são escritos em um arquivo JSON.
+
+// Etapas de um quadro medidas separadamente
+#define BENCHMARK_STAGE_SIMULATION 0 // Passos da simulação
+#define BENCHMARK_STAGE_SCENE      1 // Câmera, culling e chamadas de desenho da cena
+#define BENCHMARK_STAGE_HUD        2 // Texto na tela
+#define BENCHMARK_STAGE_PRESENT    3 // glfwSwapBuffers() e eventos da janela
+#define BENCHMARK_NUM_STAGES       4
+
+// Tempo simulado por quadro, em segundos
+#define BENCHMARK_FRAME_TIME (1.0f / 60.0f)
+
+struct Benchmark
+{
+    int                 num_frames;    // Quadros medidos
+    int                 warmup_frames; // Quadros iniciais descartados
+    int                 frame;         // Quadro atual, incluindo os descartados
+    std::vector<double> frame_times;   // Duração de cada quadro medido, em segundos
+    std::vector<double> stage_times[BENCHMARK_NUM_STAGES];
+    double              frame_start;
+    double              stage_start;
+    double              current_stages[BENCHMARK_NUM_STAGES];
+};
+
+void Benchmark_Init(Benchmark* benchmark, int num_frames, int warmup_frames);
+
+// Marcações de tempo dentro de um quadro: Benchmark_EndStage() atribui à
+// etapa "stage" o tempo decorrido desde o fim da etapa anterior (ou desde o
+// início do quadro).
+void Benchmark_BeginFrame(Benchmark* benchmark);
+void Benchmark_EndStage(Benchmark* benchmark, int stage);
+void Benchmark_EndFrame(Benchmark* benchmark);
+
+// Fração dos quadros já renderizada, entre 0 e 1
+float Benchmark_Progress(const Benchmark& benchmark);
+
+// True quando todos os quadros foram medidos
+bool Benchmark_Finished(const Benchmark& benchmark);
+
+// Escreve os resultados em "filename". "renderer" identifica a GPU/driver.
+bool Benchmark_WriteJSON(const Benchmark& benchmark, const char* filename,
+                         const char* renderer, int width, int height);
+
+#endif // BENCHMARK_H
@@ -3,6 +3,7 @@
 #ifndef COLLISIONS_H
 #define COLLISIONS_H
 
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <vector> 
 
@@ -20,12 +21,73 @@ BoundingBox ComputeCarAABB(const glm::vec4& carPosition, const glm::vec3& bbox_m
 // Verifica colisão entre a AABB do carro e a AABB do plano
 bool CheckAABBCollisionWithPlane(const BoundingBox& box, float plane_y);
 
-// Calcula o tempo para colisão vertical com um plano dado
+// Calcula o tempo para que a face de uma AABB, na coordenada
+// "bbox_min_height" e com velocidade "vel" ao longo do mesmo eixo, alcance o
+// plano "plane_height". O resultado é negativo se a face se afasta do plano,
+// e infinito se vel == 0.
 float CalculateAABBToPlaneCollisionTime(float plane_height, float bbox_min_height, float vel);
 
+// Teste contínuo (swept AABB): a AABB "moving" se desloca "displacement"
+// contra a AABB parada "target". Se elas passam a se tocar durante o
+// deslocamento, retorna true com a fração do deslocamento no instante do
+// contato em *toi (entre 0 e 1) e a normal da face de "target" atingida em
+// *normal. Caixas que já se sobrepõem no início não são consideradas.
+bool SweptAABB(
+    const BoundingBox& moving,
+    const glm::vec3& displacement,
+    const BoundingBox& target,
+    float* toi,
+    glm::vec3* normal
+);
+
 // Verifica colisão entre cubos
 bool CheckAABBCollision(const BoundingBox& a, const BoundingBox& b);
 
+// Caixa delimitadora orientada (OBB): centro, eixos locais ortonormais e
+// metade das dimensões ao longo de cada eixo
+struct OrientedBoundingBox {
+    glm::vec3 center;
+    glm::vec3 axes[3];
+    glm::vec3 half_extents;
+};
+
+// OBB do carro: bbox local do modelo girada de "carYaw" em torno do eixo Y,
+// como na renderização, e posicionada em "carPosition"
+OrientedBoundingBox ComputeCarOBB(const glm::vec4& carPosition, float carYaw, const glm::vec3& bbox_min, const glm::vec3& bbox_max);
+
+// OBB equivalente a uma AABB
+OrientedBoundingBox OBBFromAABB(const BoundingBox& box);
+
+// AABB que envolve uma OBB
+BoundingBox OBBBounds(const OrientedBoundingBox& box);
+
+// Contato entre duas caixas: normal unitária na direção em que a primeira
+// caixa deve ser empurrada para separá-las, e a profundidade de penetração
+// ao longo dela
+struct CollisionContact {
+    glm::vec3 normal;
+    float     depth;
+};
+
+// Verifica colisão entre OBBs pelo teorema do eixo separador (SAT). Se há
+// colisão e "contact" não é NULL, preenche o contato de menor penetração.
+bool CheckOBBCollision(const OrientedBoundingBox& a, const OrientedBoundingBox& b, CollisionContact* contact);
+bool CheckOBBAABBCollision(const OrientedBoundingBox& a, const BoundingBox& b, CollisionContact* contact);
+
+// Igual a CheckOBBAABBCollision(), mas com o contato restrito ao plano XZ: a
+// normal é horizontal e a profundidade é medida ao longo dela. Se a colisão
+// só pode ser desfeita na vertical, a normal do contato é nula.
+bool CheckOBBAABBCollisionXZ(const OrientedBoundingBox& a, const BoundingBox& b, CollisionContact* contact);
+
+// Equivalente a SweptAABB() para OBBs que apenas transladam
+bool SweptOBB(
+    const OrientedBoundingBox& moving,
+    const glm::vec3& displacement,
+    const OrientedBoundingBox& target,
+    float* toi,
+    glm::vec3* normal
+);
+
 bool ResolveCarWallCollision(
     glm::vec4& carPos,
     const glm::vec4& previousCarPos,
@@ -38,6 +100,83 @@ bool ResolveCarWallCollision(
     const glm::vec3& wall_scale
 );
 
+// Conjunto de AABBs em "structure of arrays": cada coordenada em um vetor
+// separado, para que CheckAABBCollisionBatch() carregue várias caixas por
+// instrução SIMD.
+struct BoundingBoxArray {
+    std::vector<float> min_x, min_y, min_z;
+    std::vector<float> max_x, max_y, max_z;
+};
+
+void AppendBoundingBox(BoundingBoxArray* array, const BoundingBox& box);
+
+// Número máximo de caixas testadas por chamada de CheckAABBCollisionBatch()
+#define AABB_BATCH_SIZE 32
+
+// Testa "box" contra as caixas boxes[first .. first+count), com count no
+// máximo AABB_BATCH_SIZE. O bit i do resultado é 1 se "box" colide com a
+// caixa first+i, com o mesmo critério de CheckAABBCollision(). Usa AVX
+// (8 caixas por instrução) ou SSE (4 caixas) quando o compilador os habilita,
+// e código escalar caso contrário.
+uint32_t CheckAABBCollisionBatch(const BoundingBox& box, const BoundingBoxArray& boxes, size_t first, size_t count);
+
+// Broadphase para as colisões do carro com obstáculos estáticos (paredes,
+// guard rails). As AABBs em coordenadas do mundo são calculadas uma única vez
+// e distribuídas em uma grade uniforme no plano XZ; cada obstáculo é inserido
+// em todas as células que sua AABB ocupa. A consulta testa somente os
+// obstáculos das células ocupadas pelo carro, de forma que o custo por passo
+// não depende do número total de obstáculos da pista.
+struct StaticColliderGrid {
+    glm::vec2                origin;     // Canto mínimo (x, z) da grade
+    float                    cell_size;
+    int                      cells_x;
+    int                      cells_z;
+    std::vector<uint32_t>    cell_start; // items[cell_start[c] .. cell_start[c+1]) pertencem à célula c
+    std::vector<uint32_t>    items;      // Índices em "boxes", crescentes dentro de cada célula
+    BoundingBoxArray         cell_boxes; // boxes[items[k]] para cada k, contíguas por célula
+    std::vector<BoundingBox> boxes;      // AABBs no mundo, na ordem de "positions"
+};
+
+// Constrói a grade para obstáculos iguais (mesma AABB local e escala)
+// posicionados em "positions".
+void BuildStaticColliderGrid(
+    StaticColliderGrid* grid,
+    const std::vector<glm::vec3>& positions,
+    const glm::vec3& bbox_min,
+    const glm::vec3& bbox_max,
+    const glm::vec3& scale,
+    float cell_size
+);
+
+// Resolve as colisões do carro, representado por uma OBB girada de "carYaw"
+// em torno do eixo Y, com os obstáculos da grade. O carro é empurrado para
+// fora de cada obstáculo ao longo da normal de contato horizontal (veja
+// CheckOBBAABBCollisionXZ()), pela profundidade de penetração, e para
+// (carSpeed = 0). Retorna true se o carro foi empurrado.
+bool ResolveCarStaticCollision(
+    glm::vec4& carPos,
+    float carYaw,
+    const glm::vec3& car_bbox_min,
+    const glm::vec3& car_bbox_max,
+    float& carSpeed,
+    const StaticColliderGrid& grid
+);
+
+// Varredura contínua da OBB do carro de "from" até "to" contra os obstáculos
+// da grade, para detectar colisões que o teste discreto perde quando o carro
+// atravessa um obstáculo fino em um único passo (tunneling). Retorna true
+// com o menor tempo de impacto em *toi e a normal do contato em *normal.
+bool SweepCarStaticColliders(
+    const glm::vec4& from,
+    const glm::vec4& to,
+    float carYaw,
+    const glm::vec3& car_bbox_min,
+    const glm::vec3& car_bbox_max,
+    const StaticColliderGrid& grid,
+    float* toi,
+    glm::vec3* normal
+);
+
 void ResolveCarGroundCollision(
     glm::vec4& carPos,
     const glm::vec3& car_bbox_min,
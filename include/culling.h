@@ -0,0 +1,60 @@
+// culling.h
+
+#ifndef CULLING_H
+#define CULLING_H
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "collisions.h"
+
+// Pirâmide de visão (view frustum) representada por seis planos
+// (esquerda, direita, baixo, cima, near, far). Cada plano é guardado como
+// (a,b,c,d), com a normal (a,b,c) unitária apontando para dentro, de forma
+// que um ponto p está dentro do plano se dot(p, (a,b,c)) + d >= 0.
+struct Frustum
+{
+    glm::vec4 planes[6];
+};
+
+// Extrai os planos do frustum a partir da matriz projection*view (método de
+// Gribb e Hartmann). Os planos ficam em coordenadas globais (World).
+Frustum ExtractFrustumPlanes(const glm::mat4& view_projection);
+
+// Retorna false somente se a AABB está certamente fora do frustum.
+bool FrustumIntersectsAABB(const Frustum& frustum, const BoundingBox& box);
+
+// Calcula a AABB, em coordenadas globais, de uma AABB local transformada
+// pela matriz de modelagem dada.
+BoundingBox TransformAABB(const glm::mat4& model, const glm::vec3& bbox_min, const glm::vec3& bbox_max);
+
+// Grade uniforme no plano XZ sobre as instâncias estáticas de um objeto.
+// Cada instância é colocada na célula que contém o centro da sua AABB, e
+// cada célula guarda a união das AABBs das suas instâncias. Durante a
+// consulta, células inteiras fora do frustum são descartadas com um único
+// teste; somente as instâncias de células visíveis são testadas
+// individualmente.
+struct InstanceGrid
+{
+    glm::vec2                 origin;       // Canto (x,z) mínimo da grade
+    float                     cell_size;
+    int                       cells_x;
+    int                       cells_z;
+    std::vector<uint32_t>     cell_start;   // Instâncias da célula i: items[cell_start[i] .. cell_start[i+1])
+    std::vector<uint32_t>     items;        // Índices das instâncias, agrupados por célula
+    std::vector<BoundingBox>  cell_bounds;  // União das AABBs das instâncias de cada célula
+    std::vector<BoundingBox>  instance_bounds;
+};
+
+// Constrói a grade para as instâncias dadas pelas suas matrizes de modelagem
+// e pela AABB local do objeto (SceneObject::bbox_min/bbox_max).
+void InstanceGrid_Build(InstanceGrid* grid, const std::vector<glm::mat4>& models,
+                        const glm::vec3& bbox_min, const glm::vec3& bbox_max, float cell_size);
+
+// Adiciona em "visible" os índices das instâncias que intersectam o frustum,
+// em ordem crescente. Retorna o número de instâncias visíveis.
+size_t InstanceGrid_Query(const InstanceGrid& grid, const Frustum& frustum, std::vector<uint32_t>* visible);
+
+#endif // CULLING_H
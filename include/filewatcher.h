@@ -0,0 +1,28 @@
+// filewatcher.h
+
+#ifndef FILEWATCHER_H
+#define FILEWATCHER_H
+
+// Observa os arquivos de um diretório, para recarregar recursos (por
+// exemplo, os shaders) assim que eles são salvos. No Linux utiliza inotify,
+// com um descritor não bloqueante lido uma vez por quadro por
+// FileWatcher_Poll(); nos demais sistemas FileWatcher_Init() retorna false e
+// FileWatcher_Poll() nunca informa mudanças.
+
+struct FileWatcher
+{
+    int fd;     // Descritor do inotify, ou -1
+    int watch;  // Diretório observado
+    char suffix[16]; // Somente arquivos terminados com este sufixo (por exemplo ".glsl")
+};
+
+// Começa a observar "directory". Retorna false se não for possível.
+bool FileWatcher_Init(FileWatcher* watcher, const char* directory, const char* suffix);
+
+// Retorna true se algum arquivo observado foi escrito, criado ou substituído
+// desde a última chamada. Não bloqueia.
+bool FileWatcher_Poll(FileWatcher* watcher);
+
+void FileWatcher_Destroy(FileWatcher* watcher);
+
+#endif // FILEWATCHER_H
@@ -0,0 +1,52 @@
+// geometryarena.h
+
+#ifndef GEOMETRYARENA_H
+#define GEOMETRYARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "mesh.h"
+
+// Arena de geometria compartilhada: todas as malhas da cena ficam em um único
+// VBO (vértices PackedVertex) e um único EBO (índices uint32), ambos
+// referenciados por um único VAO. Cada malha ocupa uma região contígua de
+// cada buffer, e é desenhada com glDrawElementsBaseVertex(), de forma que os
+// seus índices continuam relativos ao primeiro vértice da própria malha.
+//
+// A sub-alocação é linear: as regiões são reservadas em sequência e nunca
+// liberadas individualmente, pois toda a geometria da cena vive até o fim
+// do programa. Quando a capacidade acaba, os buffers são realocados com o
+// dobro do tamanho e o conteúdo anterior é copiado na própria GPU.
+
+// Região ocupada por uma malha dentro da arena.
+struct GeometryRange
+{
+    GLint  base_vertex;  // Somado a cada índice da malha (glDrawElementsBaseVertex)
+    size_t first_index;  // Posição do primeiro índice da malha dentro do EBO
+    size_t num_vertices;
+    size_t num_indices;
+};
+
+// Cria o VAO e os buffers com a capacidade inicial dada (em número de
+// vértices e de índices). Uma boa estimativa evita realocações.
+void GeometryArena_Init(size_t vertex_capacity, size_t index_capacity);
+
+// Libera o VAO e os buffers da arena.
+void GeometryArena_Destroy();
+
+// Reserva espaço para uma malha e envia seus vértices e índices para a GPU.
+GeometryRange GeometryArena_Upload(const std::vector<PackedVertex>& vertices, const std::vector<uint32_t>& indices);
+
+// "Liga" o VAO da arena. Todos os objetos da cena são desenhados com ele.
+void GeometryArena_Bind();
+
+// Acesso aos objetos OpenGL da arena.
+GLuint GeometryArena_VertexArrayObject();
+GLuint GeometryArena_VertexBuffer();
+GLuint GeometryArena_IndexBuffer();
+
+#endif // GEOMETRYARENA_H
@@ -0,0 +1,50 @@
+// gputimer.h
+
+#ifndef GPUTIMER_H
+#define GPUTIMER_H
+
+#include <glad/glad.h>
+
+// Tempo de GPU de cada grupo de chamadas de desenho ("passe"), medido com
+// consultas GL_TIME_ELAPSED (OpenGL 3.3). As consultas de cada quadro só são
+// lidas GPU_TIMER_LATENCY quadros depois, quando a GPU normalmente já as
+// terminou; se o resultado ainda não estiver disponível, o quadro é
+// descartado em vez de esperar pela GPU. Assim a medição nunca bloqueia o
+// pipeline.
+//
+// Somente uma consulta GL_TIME_ELAPSED pode estar ativa por vez, então os
+// passes não podem ser aninhados.
+
+// Passes medidos
+#define GPU_PASS_CLEAR      0 // glClear()
+#define GPU_PASS_TRACK      1 // Pista
+#define GPU_PASS_WALLS      2 // Paredes (instanciadas)
+#define GPU_PASS_ARCS       3 // Arcos
+#define GPU_PASS_GUARDRAILS 4 // Guard rails (instanciados)
+#define GPU_PASS_PEOPLE     5 // Espectadores (instanciados)
+#define GPU_PASS_GRANDMA    6 // Vovó
+#define GPU_PASS_CARS       7 // Carros do jogador e da IA
+#define GPU_PASS_TEXT       8 // Texto na tela
+#define GPU_NUM_PASSES      9
+
+// Quadros entre a medição e a leitura (número de conjuntos de consultas)
+#define GPU_TIMER_LATENCY 2
+
+// Cria as consultas. Deve ser chamada com o contexto OpenGL atual.
+void GpuTimer_Init();
+
+// Lê os resultados do conjunto de consultas que será reutilizado neste
+// quadro. Deve ser chamada no início de cada quadro, antes de GpuTimer_Begin().
+void GpuTimer_BeginFrame();
+
+// Delimitam as chamadas OpenGL de um passe
+void GpuTimer_Begin(int pass);
+void GpuTimer_End();
+
+// Tempo de GPU do passe, em milissegundos, suavizado ao longo dos quadros
+float GpuTimer_Milliseconds(int pass);
+
+// Nome do passe, para o HUD e o trace de profiling
+const char* GpuTimer_PassName(int pass);
+
+#endif // GPUTIMER_H
@@ -0,0 +1,33 @@
+// headless.h
+
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+// Modo "headless": executa corridas somente com o núcleo da simulação (veja
+// "simulation.h"), sem criar janela nem contexto OpenGL, tão rápido quanto a
+// CPU permitir. Útil para balanceamento da IA e testes de regressão em
+// máquinas sem monitor. Uso:
+//
+//     main --headless [--races N] [--difficulty 0|1|2] [--script ARQUIVO]
+//                     [--max-time SEGUNDOS] [--replay ARQUIVO]
+//                     [--record ARQUIVO]
+//
+// O arquivo de script define as teclas pressionadas pelo jogador a partir de
+// cada passo da simulação, uma entrada por linha:
+//
+//     # passo  teclas
+//     0        W
+//     900      WA
+//     960      W
+//
+// onde as teclas são W, A, S e D, ou "-" para nenhuma. Sem script, o jogador
+// mantém W pressionado durante toda a corrida.
+//
+// Com --replay, as teclas e a dificuldade vêm de um replay (veja "replay.h")
+// em vez do script, e o estado final de cada corrida é comparado com o da
+// gravação. Com --record, a primeira corrida é gravada em um replay.
+//
+// Retorna o código de saída do programa.
+int Headless_Run(int argc, char* argv[]);
+
+#endif // HEADLESS_H
@@ -0,0 +1,50 @@
+// instancing.h
+
+#ifndef INSTANCING_H
+#define INSTANCING_H
+
+#include <cstddef>
+
+#include <glad/glad.h>
+#include <glm/mat4x4.hpp>
+
+// Desenho instanciado: as matrizes "model" de cada instância são copiadas
+// para um VBO de instâncias e lidas pelo Vertex Shader através do atributo
+// "instance_model" (locations 3 a 6, uma por coluna da matriz), que avança
+// uma vez por instância (glVertexAttribDivisor). Assim, N cópias de um
+// mesmo objeto são desenhadas com um único glDrawElementsInstanced*().
+//
+// O VBO de instâncias é reescrito a cada quadro (veja
+// Instancing_BeginFrame()), o que permite enviar apenas as instâncias
+// visíveis. Fora do desenho instanciado, os arrays destes atributos ficam
+// desligados e o shader utiliza o valor constante do atributo, que é a
+// matriz identidade.
+//
+// As matrizes de instância devem ser composições de translações, rotações e
+// escalas uniformes: o shader transforma as normais diretamente pela parte
+// 3x3 de "instance_model", sem a inversa da transposta, o que só é válido
+// (a menos do comprimento da normal) para esse tipo de matriz.
+
+// Primeira coluna de "instance_model" em "shader_vertex.glsl".
+#define INSTANCE_MODEL_LOCATION 3
+
+// Cria o VBO de instâncias e define a matriz identidade como valor constante
+// de "instance_model".
+void Instancing_Init();
+
+// Descarta as instâncias enviadas no quadro anterior. Deve ser chamada uma
+// vez por quadro, antes de qualquer Instancing_Upload().
+void Instancing_BeginFrame();
+
+// Copia "count" matrizes para o VBO de instâncias e retorna a posição da
+// primeira delas (utilizada em Instancing_EnableAttributes()).
+size_t Instancing_Upload(const glm::mat4* matrices, size_t count);
+
+// Liga/desliga os atributos de instância no VAO atual, apontando para as
+// matrizes a partir de "first_instance". OpenGL 3.3 não possui
+// glDrawElementsInstancedBaseInstance(), então o deslocamento é feito
+// diretamente no ponteiro dos atributos.
+void Instancing_EnableAttributes(size_t first_instance);
+void Instancing_DisableAttributes();
+
+#endif // INSTANCING_H
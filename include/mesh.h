@@ -0,0 +1,81 @@
+// mesh.h
+
+#ifndef MESH_H
+#define MESH_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include <tiny_obj_loader.h>
+
+// Estrutura que representa um modelo geométrico carregado a partir de um
+// arquivo ".obj". Veja https://en.wikipedia.org/wiki/Wavefront_.obj_file .
+struct ObjModel
+{
+    tinyobj::attrib_t                 attrib;
+    std::vector<tinyobj::shape_t>     shapes;
+    std::vector<tinyobj::material_t>  materials;
+
+    // Este construtor lê o modelo de um arquivo utilizando a biblioteca tinyobjloader.
+    // Veja: https://github.com/syoyo/tinyobjloader
+    ObjModel(const char* filename, const char* basepath = NULL, bool triangulate = true);
+};
+
+// Intervalo de índices ocupado por uma "shape" do arquivo OBJ dentro de
+// MeshData::indices, junto com sua Axis-Aligned Bounding Box.
+struct MeshShape
+{
+    std::string  name;        // Nome do objeto
+    size_t       first_index; // Índice do primeiro elemento dentro de MeshData::indices
+    size_t       num_indices; // Número de índices do objeto
+    glm::vec3    bbox_min;    // Axis-Aligned Bounding Box do objeto
+    glm::vec3    bbox_max;
+};
+
+// Vértice no formato compacto e intercalado que é enviado para a GPU
+// (16 bytes, em vez dos 40 bytes de vec4+vec4+vec2 em float). Decodificado em
+// "shader_vertex.glsl".
+struct PackedVertex
+{
+    uint16_t position[4]; // XYZ normalizados (unorm16) dentro da bbox da shape; W não utilizado
+    int16_t  normal[2];   // Normal em codificação octaédrica (snorm16)
+    uint16_t texcoord[2]; // Coordenadas de textura (half-float)
+};
+
+// Malha de triângulos já no formato final que é enviado para a GPU. Este é o
+// resultado da parte "CPU" de BuildTrianglesAndAddToVirtualScene(): não
+// depende de OpenGL e pode ser guardado em disco (veja MeshCache_Save()).
+// Cada vértice pertence a uma única shape, pois sua posição é quantizada
+// em relação à bbox dessa shape.
+struct MeshData
+{
+    std::vector<PackedVertex> vertices;  // Vértices únicos de todas as shapes
+    std::vector<uint32_t>     indices;   // Índices dos triângulos (GL_TRIANGLES)
+    std::vector<MeshShape>    shapes;    // Uma entrada por objeto do arquivo OBJ
+};
+
+// Computa normais de um ObjModel, caso não existam.
+void ComputeNormals(ObjModel* model);
+
+// Escala as coordenadas da malha e da textura de um modelo (utilizado no plano da pista)
+void ScalePlaneModelAndTexCoords(ObjModel* model, float scale);
+
+// Constrói os vetores de vértices e índices de um ObjModel (sem chamadas OpenGL)
+void BuildMeshData(ObjModel* model, MeshData* mesh);
+
+// Lê/escreve a versão binária de uma malha, guardada ao lado do arquivo ".obj"
+// (por exemplo "car.obj" -> "car.obj.meshcache"). O cache é invalidado quando
+// o tamanho ou a data de modificação do ".obj" mudam, quando a escala aplicada
+// é diferente, ou quando MESH_CACHE_VERSION muda.
+bool MeshCache_Load(const char* obj_filename, float scale, MeshData* mesh);
+bool MeshCache_Save(const char* obj_filename, float scale, const MeshData& mesh);
+
+// Carrega um modelo ".obj" utilizando o cache binário quando possível. Caso
+// contrário, faz a leitura com tinyobjloader, computa as normais, constrói a
+// malha e atualiza o cache para as próximas execuções.
+void LoadMeshData(const char* filename, MeshData* mesh, float scale = 1.0f);
+
+#endif // MESH_H
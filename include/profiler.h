@@ -0,0 +1,132 @@
+// profiler.h
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Profiling de CPU por escopos. Cada escopo marcado com PROFILE_SCOPE()
+// registra o seu início, a sua duração e a thread que o executou em um
+// buffer circular com os PROFILER_MAX_EVENTS escopos mais recentes (cerca de
+// meio minuto de jogo). O buffer pode ser salvo no formato "trace_event" do
+// Chrome e aberto em chrome://tracing ou https://ui.perfetto.dev:
+//
+//     main --profile trace.json   (salva ao fechar a janela)
+//
+// ou pressionando F8 durante o jogo. Enquanto o profiling está desabilitado
+// (o padrão), cada escopo custa somente a leitura de uma flag. Compilando
+// com FCG_DISABLE_PROFILING os escopos são removidos por completo.
+//
+// Escopos encadeados sem blocos próprios, como as etapas de um quadro, podem
+// ser marcados com um único ProfileScope e ProfileScope::Next():
+//
+//     ProfileScope phase("Simulação");
+//     ...
+//     phase.Next("Câmera");
+//     ...
+
+#define PROFILER_MAX_EVENTS (1 << 16) // Potência de dois
+#define PROFILER_GPU_THREAD 0xFFFFu
+
+// Escopo medido
+struct ProfileEvent
+{
+    const char* name;       // String estática (literal)
+    char        detail[32]; // Texto adicional (por exemplo, um nome de arquivo), ou vazio
+    double      start;      // Microssegundos desde Profiler_Init()
+    double      duration;   // Microssegundos
+    uint32_t    thread;     // 0 para a thread principal, 1, 2, ... para as demais,
+                            // ou PROFILER_GPU_THREAD
+};
+
+extern std::atomic<bool> g_ProfilerEnabled;
+
+// Deve ser chamada pela thread principal antes de qualquer escopo
+void Profiler_Init();
+
+// Liga/desliga a coleta dos escopos
+void Profiler_SetEnabled(bool enabled);
+
+// Tempo atual, em microssegundos desde Profiler_Init()
+double Profiler_Now();
+
+// Adiciona um escopo ao buffer. "detail" pode ser NULL.
+void Profiler_Record(const char* name, const char* detail, double start, double end);
+
+// Adiciona ao buffer um intervalo executado pela GPU (veja "gputimer.h"),
+// mostrado no trace em uma linha própria, PROFILER_GPU_THREAD.
+void Profiler_RecordGPU(const char* name, double start, double end);
+
+// Escreve os escopos do buffer, do mais antigo para o mais recente, no
+// formato JSON "trace_event" do Chrome. Deve ser chamada quando nenhuma
+// outra thread estiver registrando escopos.
+bool Profiler_WriteChromeTrace(const char* filename);
+
+#ifndef FCG_DISABLE_PROFILING
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char* name, const char* detail = NULL)
+        : name(name), detail(detail), start(-1.0)
+    {
+        if ( g_ProfilerEnabled.load(std::memory_order_relaxed) )
+            start = Profiler_Now();
+    }
+
+    ~ProfileScope()
+    {
+        if ( start >= 0.0 )
+            Profiler_Record(name, detail, start, Profiler_Now());
+    }
+
+    // Encerra o escopo atual e inicia o escopo "next_name"
+    void Next(const char* next_name)
+    {
+        double now = -1.0;
+        if ( start >= 0.0 )
+        {
+            now = Profiler_Now();
+            Profiler_Record(name, detail, start, now);
+        }
+        else if ( g_ProfilerEnabled.load(std::memory_order_relaxed) )
+        {
+            now = Profiler_Now();
+        }
+        name   = next_name;
+        detail = NULL;
+        start  = now;
+    }
+
+private:
+    ProfileScope(const ProfileScope&);
+    ProfileScope& operator=(const ProfileScope&);
+
+    const char* name;
+    const char* detail;
+    double      start; // Negativo se o profiling estava desabilitado no início
+};
+
+#else // FCG_DISABLE_PROFILING
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char*, const char* = NULL) {}
+    void Next(const char*) {}
+};
+
+#endif // FCG_DISABLE_PROFILING
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b)  PROFILE_CONCAT_(a, b)
+
+// Mede o restante do bloco atual
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+
+// Idem, com um texto adicional copiado para o evento (truncado em 31 caracteres)
+#define PROFILE_SCOPE_DETAIL(name, detail) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name, detail)
+
+#endif // PROFILER_H
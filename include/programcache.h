@@ -0,0 +1,41 @@
+// programcache.h
+
+#ifndef PROGRAMCACHE_H
+#define PROGRAMCACHE_H
+
+#include <string>
+
+#include <glad/glad.h>
+
+// Cache em disco dos programas de GPU já linkados. O binário de cada
+// programa é obtido com glGetProgramBinary() e guardado em
+// "../data/shaders/<nome>.programcache"; na próxima execução ele é enviado
+// de volta com glProgramBinary(), evitando compilar e linkar os shaders.
+//
+// Cada arquivo guarda um hash do código fonte dos shaders e da string do
+// driver (GL_VENDOR, GL_RENDERER e GL_VERSION). Se o código ou o driver
+// mudarem, ou se o driver recusar o binário, ProgramCache_Load() retorna 0
+// e o programa deve ser compilado normalmente e salvo com
+// ProgramCache_Save(), que sobrescreve o arquivo antigo.
+//
+// glGetProgramBinary() e glProgramBinary() são do OpenGL 4.1 (ou da extensão
+// GL_ARB_get_program_binary) e não fazem parte do glad para OpenGL 3.3, então
+// são carregadas manualmente em ProgramCache_Init(). Sem suporte do driver,
+// o cache fica desligado e todas as funções abaixo não fazem nada.
+
+// Carrega as funções necessárias. Deve ser chamada com o contexto OpenGL
+// atual, após gladLoadGLLoader().
+void ProgramCache_Init();
+
+// Deve ser chamada antes de glLinkProgram(), para avisar o driver de que o
+// binário do programa será lido depois (veja CreateGpuProgram()).
+void ProgramCache_PrepareLink(GLuint program_id);
+
+// Cria um programa a partir do binário guardado em "name", ou retorna 0 se
+// não houver um binário válido para estes shaders e este driver.
+GLuint ProgramCache_Load(const char* name, const std::string& vertex_source, const std::string& fragment_source);
+
+// Guarda o binário de um programa linkado com sucesso.
+bool ProgramCache_Save(const char* name, GLuint program_id, const std::string& vertex_source, const std::string& fragment_source);
+
+#endif // PROGRAMCACHE_H
@@ -0,0 +1,55 @@
+// replay.h
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstdint>
+#include <vector>
+
+#include "simulation.h"
+
+// Gravação e reprodução determinística de corridas. Como a simulação avança
+// em passos fixos (veja "simulation.h"), as teclas pressionadas em cada passo
+// e o passo em que a dificuldade foi escolhida bastam para reproduzir a
+// corrida exatamente, com ou sem janela:
+//
+//     main --record corrida.replay
+//     main --replay corrida.replay
+//     main --headless --replay corrida.replay [--races N]
+//
+// No arquivo, as teclas são armazenadas com run-length encoding: cada trecho
+// de passos consecutivos com as mesmas teclas ocupa 5 bytes.
+struct Replay
+{
+    int                          difficulty_level; // -1 se não foi escolhida
+    uint64_t                     difficulty_tick;  // Passo em que a dificuldade foi escolhida
+    std::vector<SimulationInput> inputs;           // Teclas de cada passo
+    uint64_t                     final_checksum;   // Replay_Checksum() após o último passo
+};
+
+// Replay vazio
+void Replay_Init(Replay* replay);
+
+// Gravação: chame Replay_RecordStep() com as teclas de cada passo, antes de
+// Simulation_Step(), e Replay_RecordDifficulty() logo após
+// Simulation_ChooseDifficulty().
+void Replay_RecordStep(Replay* replay, const SimulationState& state, SimulationInput input);
+void Replay_RecordDifficulty(Replay* replay, const SimulationState& state);
+
+// Reprodução: aplica a escolha de dificuldade gravada, se for o passo dela, e
+// retorna as teclas do próximo passo de "state". Após o fim do replay
+// nenhuma tecla é pressionada.
+SimulationInput Replay_InputForStep(const Replay& replay, SimulationState* state);
+
+// True se "state" já executou todos os passos do replay
+bool Replay_Finished(const Replay& replay, const SimulationState& state);
+
+// Hash do estado dos carros, para verificar se a reprodução chegou ao mesmo
+// resultado que a gravação.
+uint64_t Replay_Checksum(const SimulationState& state);
+
+// Lê e escreve o arquivo de replay. Retornam false em caso de erro.
+bool Replay_Load(const char* filename, Replay* replay);
+bool Replay_Save(const char* filename, const Replay& replay);
+
+#endif // REPLAY_H
@@ -0,0 +1,113 @@
+// simulation.h
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "collisions.h"
+
+// Núcleo da simulação da corrida: física dos carros, IA e colisões. Não
+// depende de OpenGL nem de GLFW, e pode ser executado tanto pelo laço de
+// renderização em main() quanto sem janela (veja "headless.h").
+
+// A simulação avança em passos fixos de SIMULATION_TIMESTEP segundos.
+#define SIMULATION_HZ 120
+const float SIMULATION_TIMESTEP = 1.0f / SIMULATION_HZ;
+
+// Escala aplicada ao modelo da pista ("track.obj")
+#define TRACK_PLANE_SCALE 50.0f
+
+// Coordenada Z da linha de chegada
+#define RACE_FINISH_Z 400.0f
+
+// Tempo de contagem regressiva antes da largada, em segundos
+#define RACE_COUNTDOWN 5.0f
+
+// Teclas de controle do carro do jogador em um passo da simulação, como
+// máscara de bits (SimulationInput).
+#define SIMULATION_KEY_W 0x1 // Acelera
+#define SIMULATION_KEY_A 0x2 // Vira à esquerda
+#define SIMULATION_KEY_S 0x4 // Freia / ré
+#define SIMULATION_KEY_D 0x8 // Vira à direita
+typedef uint8_t SimulationInput;
+
+// Resultado da corrida (veja Simulation_Winner())
+#define RACE_WINNER_NONE   0
+#define RACE_WINNER_PLAYER 1
+#define RACE_WINNER_PC     2
+
+// Escala aplicada às AABBs das paredes e dos guard rails nos testes de colisão
+#define WALL_SCALE      0.01f
+#define GUARDRAIL_SCALE 0.8f
+
+// Dados estáticos da pista utilizados pela simulação: bounding boxes dos
+// carros e obstáculos, posições das paredes e dos guard rails, e as grades de
+// broadphase com as AABBs dos obstáculos no mundo.
+struct TrackColliders
+{
+    float                  plane_size;
+    glm::vec3              plane_position;
+    float                  car_height;       // Altura inicial do carro do jogador
+    float                  car_height_pc;    // Altura inicial do carro da IA
+    glm::vec3              car_bbox_min;
+    glm::vec3              car_bbox_max;
+    glm::vec3              car_pc_bbox_min;
+    glm::vec3              car_pc_bbox_max;
+    std::vector<glm::vec3> wall_positions;
+    glm::vec3              wall_bbox_min;
+    glm::vec3              wall_bbox_max;
+    std::vector<glm::vec3> guardRail_positions;
+    glm::vec3              guardRail_bbox_min;
+    glm::vec3              guardRail_bbox_max;
+    StaticColliderGrid     wall_grid;
+    StaticColliderGrid     guardRail_grid;
+};
+
+// Estado dinâmico da corrida
+struct SimulationState
+{
+    glm::vec4 car_pos;          // Posição do carro do jogador
+    glm::vec3 car_velocity;     // Velocidade vertical (gravidade) do carro do jogador
+    float     car_yaw;          // Rotação do carro em torno do eixo Y (guinada)
+    float     car_speed;        // Velocidade atual do carro
+
+    glm::vec4 car_pos_pc;       // Posição do carro 2 player (pc)
+    float     car_yaw_pc;
+    float     car_speed_pc;
+
+    int       difficulty_level;  // 0 = fácil, 1 = médio, 2 = difícil
+    bool      difficulty_chosen; // True se o jogador já escolheu a dificuldade
+    bool      race_started;
+    double    race_time;         // Tempo simulado desde a escolha da dificuldade
+    uint64_t  tick;              // Número de passos executados
+};
+
+// Função que informa a AABB de um objeto da cena pelo nome. Objetos que não
+// existem devem ter AABB nula.
+typedef std::function<void(const char* name, glm::vec3* bbox_min, glm::vec3* bbox_max)> BoundingBoxLookup;
+
+// Posições das paredes na linha de chegada e dos guard rails ao longo da pista
+std::vector<glm::vec3> Simulation_WallPositions();
+std::vector<glm::vec3> Simulation_GuardRailPositions();
+
+// Preenche os dados estáticos da pista a partir das AABBs dos objetos
+void Simulation_BuildTrack(TrackColliders* track, const BoundingBoxLookup& lookup, const glm::vec3& plane_position);
+
+// Coloca os carros na largada
+void Simulation_Init(SimulationState* state, const TrackColliders& track);
+
+// Escolhe a dificuldade da IA e inicia a contagem regressiva
+void Simulation_ChooseDifficulty(SimulationState* state, int level);
+
+// Avança a simulação em um passo de "deltaTime" segundos
+void Simulation_Step(SimulationState* state, SimulationInput input, const TrackColliders& track, float deltaTime);
+
+// Retorna RACE_WINNER_PLAYER, RACE_WINNER_PC ou RACE_WINNER_NONE
+int Simulation_Winner(const SimulationState& state);
+
+#endif // SIMULATION_H
@@ -0,0 +1,125 @@
+#include "assetloader.h"
+
+#include <cstdio>
+#include <exception>
+
+#include <stb_image.h>
+
+#include "profiler.h"
+
+AssetLoader::AssetLoader(unsigned int num_threads)
+    : pending(0), stopping(false)
+{
+    if ( num_threads == 0 )
+        num_threads = std::thread::hardware_concurrency();
+    if ( num_threads == 0 )
+        num_threads = 4;
+
+    // stbi_set_flip_vertically_on_load() altera uma variável global da
+    // stb_image, então a definimos aqui, antes das threads começarem a ler.
+    stbi_set_flip_vertically_on_load(true);
+
+    for (unsigned int i = 0; i < num_threads; ++i)
+        workers.push_back(std::thread(&AssetLoader::WorkerLoop, this));
+}
+
+AssetLoader::~AssetLoader()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    job_available.notify_all();
+
+    for (size_t i = 0; i < workers.size(); ++i)
+        workers[i].join();
+
+    FreeImages();
+}
+
+void AssetLoader::AddMesh(const char* filename, float scale)
+{
+    // std::deque não invalida referências para elementos existentes ao
+    // inserir no final, então cada thread pode escrever diretamente no seu
+    // resultado enquanto outros pedidos são adicionados.
+    meshes.push_back(LoadedMesh());
+    LoadedMesh* result = &meshes.back();
+    result->filename = filename;
+    result->scale = scale;
+
+    Enqueue([result]() {
+        PROFILE_SCOPE_DETAIL("LoadMeshData", result->filename.c_str());
+        try {
+            LoadMeshData(result->filename.c_str(), &result->mesh, result->scale);
+        } catch ( std::exception& e ) {
+            result->error = e.what();
+        }
+    });
+}
+
+void AssetLoader::AddImage(const char* filename)
+{
+    images.push_back(LoadedImage());
+    LoadedImage* result = &images.back();
+    result->filename = filename;
+    result->data = NULL;
+    result->width = 0;
+    result->height = 0;
+
+    Enqueue([result]() {
+        PROFILE_SCOPE_DETAIL("stbi_load", result->filename.c_str());
+        int channels;
+        result->data = stbi_load(result->filename.c_str(), &result->width, &result->height, &channels, 3);
+    });
+}
+
+void AssetLoader::Wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    all_done.wait(lock, [this]() { return pending == 0; });
+}
+
+void AssetLoader::FreeImages()
+{
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        if ( images[i].data != NULL )
+            stbi_image_free(images[i].data);
+        images[i].data = NULL;
+    }
+}
+
+void AssetLoader::Enqueue(const std::function<void()>& job)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        jobs.push_back(job);
+        pending += 1;
+    }
+    job_available.notify_one();
+}
+
+void AssetLoader::WorkerLoop()
+{
+    for (;;)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            job_available.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            if ( jobs.empty() )
+                return;
+            job = jobs.front();
+            jobs.pop_front();
+        }
+
+        job();
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            pending -= 1;
+            if ( pending == 0 )
+                all_done.notify_all();
+        }
+    }
+}
@@ -0,0 +1,157 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+static const char* const STAGE_NAMES[BENCHMARK_NUM_STAGES] = {
+    "simulation", "scene", "hud", "present"
+};
+
+static double Now()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Benchmark_Init(Benchmark* benchmark, int num_frames, int warmup_frames)
+{
+    benchmark->num_frames    = num_frames;
+    benchmark->warmup_frames = warmup_frames;
+    benchmark->frame         = 0;
+    benchmark->frame_times.clear();
+    benchmark->frame_times.reserve(num_frames);
+    for (int s = 0; s < BENCHMARK_NUM_STAGES; ++s)
+    {
+        benchmark->stage_times[s].clear();
+        benchmark->stage_times[s].reserve(num_frames);
+        benchmark->current_stages[s] = 0.0;
+    }
+    benchmark->frame_start = 0.0;
+    benchmark->stage_start = 0.0;
+}
+
+void Benchmark_BeginFrame(Benchmark* benchmark)
+{
+    benchmark->frame_start = Now();
+    benchmark->stage_start = benchmark->frame_start;
+    for (int s = 0; s < BENCHMARK_NUM_STAGES; ++s)
+        benchmark->current_stages[s] = 0.0;
+}
+
+void Benchmark_EndStage(Benchmark* benchmark, int stage)
+{
+    double now = Now();
+    benchmark->current_stages[stage] += now - benchmark->stage_start;
+    benchmark->stage_start = now;
+}
+
+void Benchmark_EndFrame(Benchmark* benchmark)
+{
+    double now = Now();
+    if ( benchmark->frame >= benchmark->warmup_frames && !Benchmark_Finished(*benchmark) )
+    {
+        benchmark->frame_times.push_back(now - benchmark->frame_start);
+        for (int s = 0; s < BENCHMARK_NUM_STAGES; ++s)
+            benchmark->stage_times[s].push_back(benchmark->current_stages[s]);
+    }
+    benchmark->frame += 1;
+}
+
+float Benchmark_Progress(const Benchmark& benchmark)
+{
+    int total = benchmark.warmup_frames + benchmark.num_frames;
+    return total > 1 ? std::min(1.0f, (float)benchmark.frame / (total - 1)) : 1.0f;
+}
+
+bool Benchmark_Finished(const Benchmark& benchmark)
+{
+    return (int)benchmark.frame_times.size() >= benchmark.num_frames;
+}
+
+struct TimeSummary
+{
+    double min, avg, p99, max;
+};
+
+// Estatísticas de uma série de tempos, em milissegundos
+static TimeSummary Summarize(const std::vector<double>& times)
+{
+    TimeSummary summary = { 0.0, 0.0, 0.0, 0.0 };
+    if ( times.empty() )
+        return summary;
+
+    std::vector<double> sorted(times);
+    std::sort(sorted.begin(), sorted.end());
+
+    double sum = 0.0;
+    for (size_t i = 0; i < sorted.size(); ++i)
+        sum += sorted[i];
+
+    size_t p99_index = (size_t)std::ceil(0.99 * sorted.size()) - 1;
+    summary.min = sorted.front() * 1000.0;
+    summary.avg = sum / sorted.size() * 1000.0;
+    summary.p99 = sorted[p99_index] * 1000.0;
+    summary.max = sorted.back() * 1000.0;
+    return summary;
+}
+
+static std::string EscapeJSON(const char* text)
+{
+    std::string escaped;
+    for (const char* c = text; *c != '\0'; ++c)
+    {
+        if ( *c == '"' || *c == '\\' )
+            escaped += '\\';
+        if ( (unsigned char)*c >= 0x20 )
+            escaped += *c;
+    }
+    return escaped;
+}
+
+static void WriteSummary(FILE* file, const char* name, const TimeSummary& summary, const char* suffix)
+{
+    fprintf(file, "    \"%s\": { \"min\": %.4f, \"avg\": %.4f, \"p99\": %.4f, \"max\": %.4f }%s\n",
+            name, summary.min, summary.avg, summary.p99, summary.max, suffix);
+}
+
+bool Benchmark_WriteJSON(const Benchmark& benchmark, const char* filename,
+                         const char* renderer, int width, int height)
+{
+    FILE* file = fopen(filename, "w");
+    if ( file == NULL )
+    {
+        fprintf(stderr, "ERROR: Cannot write benchmark results \"%s\".\n", filename);
+        return false;
+    }
+
+    TimeSummary frame = Summarize(benchmark.frame_times);
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"renderer\": \"%s\",\n", EscapeJSON(renderer).c_str());
+    fprintf(file, "  \"width\": %d,\n", width);
+    fprintf(file, "  \"height\": %d,\n", height);
+    fprintf(file, "  \"frames\": %d,\n", (int)benchmark.frame_times.size());
+    fprintf(file, "  \"warmup_frames\": %d,\n", benchmark.warmup_frames);
+    fprintf(file, "  \"avg_fps\": %.2f,\n", frame.avg > 0.0 ? 1000.0 / frame.avg : 0.0);
+    fprintf(file, "  \"frame_time_ms\": { \"min\": %.4f, \"avg\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n",
+            frame.min, frame.avg, frame.p99, frame.max);
+    fprintf(file, "  \"stage_cpu_time_ms\": {\n");
+    for (int s = 0; s < BENCHMARK_NUM_STAGES; ++s)
+        WriteSummary(file, STAGE_NAMES[s], Summarize(benchmark.stage_times[s]),
+                     s + 1 < BENCHMARK_NUM_STAGES ? "," : "");
+    fprintf(file, "  }\n");
+    fprintf(file, "}\n");
+
+    bool ok = fclose(file) == 0;
+    if ( !ok )
+    {
+        fprintf(stderr, "ERROR: Cannot write benchmark results \"%s\".\n", filename);
+        return false;
+    }
+
+    printf("Benchmark: %d quadros, %.3f ms/quadro em média (p99 %.3f ms). Resultados em \"%s\".\n",
+           (int)benchmark.frame_times.size(), frame.avg, frame.p99, filename);
+    return true;
+}
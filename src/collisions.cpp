@@ -2,6 +2,19 @@
 #include <glm/glm.hpp>
 #include <iostream>
 #include <algorithm>
+#include <cmath>
+#include <limits>
+
+// O teste de colisão em lote usa AVX quando o compilador o habilita (por
+// exemplo, com a opção FCG_ENABLE_AVX2 do CMake) e SSE, presente em todo
+// processador x86-64, caso contrário.
+#if defined(__AVX__)
+#define COLLISIONS_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COLLISIONS_SSE
+#include <emmintrin.h>
+#endif
 
 bool CheckAABBCollision(const BoundingBox& a, const BoundingBox& b) {
     if (a.max.x < b.min.x || a.min.x > b.max.x) return false;
@@ -10,6 +23,78 @@ bool CheckAABBCollision(const BoundingBox& a, const BoundingBox& b) {
     return true;
 }
 
+void AppendBoundingBox(BoundingBoxArray* array, const BoundingBox& box) {
+    array->min_x.push_back(box.min.x);
+    array->min_y.push_back(box.min.y);
+    array->min_z.push_back(box.min.z);
+    array->max_x.push_back(box.max.x);
+    array->max_y.push_back(box.max.y);
+    array->max_z.push_back(box.max.z);
+}
+
+uint32_t CheckAABBCollisionBatch(const BoundingBox& box, const BoundingBoxArray& boxes, size_t first, size_t count) {
+    const float* min_x = boxes.min_x.data() + first;
+    const float* min_y = boxes.min_y.data() + first;
+    const float* min_z = boxes.min_z.data() + first;
+    const float* max_x = boxes.max_x.data() + first;
+    const float* max_y = boxes.max_y.data() + first;
+    const float* max_z = boxes.max_z.data() + first;
+
+    uint32_t hits = 0;
+    size_t i = 0;
+
+    // Assim como em CheckAABBCollision(), calculamos a máscara dos eixos
+    // separados (comparações "<" e ">" ordenadas) e a negamos, de forma que
+    // o resultado seja idêntico ao escalar mesmo com NaN.
+#if defined(COLLISIONS_AVX)
+    const __m256 a_min_x = _mm256_set1_ps(box.min.x), a_max_x = _mm256_set1_ps(box.max.x);
+    const __m256 a_min_y = _mm256_set1_ps(box.min.y), a_max_y = _mm256_set1_ps(box.max.y);
+    const __m256 a_min_z = _mm256_set1_ps(box.min.z), a_max_z = _mm256_set1_ps(box.max.z);
+
+    for (; i + 8 <= count; i += 8) {
+        __m256 separated =
+            _mm256_or_ps(_mm256_cmp_ps(a_max_x, _mm256_loadu_ps(min_x + i), _CMP_LT_OQ),
+                         _mm256_cmp_ps(a_min_x, _mm256_loadu_ps(max_x + i), _CMP_GT_OQ));
+        separated = _mm256_or_ps(separated,
+            _mm256_or_ps(_mm256_cmp_ps(a_max_y, _mm256_loadu_ps(min_y + i), _CMP_LT_OQ),
+                         _mm256_cmp_ps(a_min_y, _mm256_loadu_ps(max_y + i), _CMP_GT_OQ)));
+        separated = _mm256_or_ps(separated,
+            _mm256_or_ps(_mm256_cmp_ps(a_max_z, _mm256_loadu_ps(min_z + i), _CMP_LT_OQ),
+                         _mm256_cmp_ps(a_min_z, _mm256_loadu_ps(max_z + i), _CMP_GT_OQ)));
+        hits |= (~(uint32_t)_mm256_movemask_ps(separated) & 0xFFu) << i;
+    }
+#elif defined(COLLISIONS_SSE)
+    const __m128 a_min_x = _mm_set1_ps(box.min.x), a_max_x = _mm_set1_ps(box.max.x);
+    const __m128 a_min_y = _mm_set1_ps(box.min.y), a_max_y = _mm_set1_ps(box.max.y);
+    const __m128 a_min_z = _mm_set1_ps(box.min.z), a_max_z = _mm_set1_ps(box.max.z);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 separated =
+            _mm_or_ps(_mm_cmplt_ps(a_max_x, _mm_loadu_ps(min_x + i)),
+                      _mm_cmpgt_ps(a_min_x, _mm_loadu_ps(max_x + i)));
+        separated = _mm_or_ps(separated,
+            _mm_or_ps(_mm_cmplt_ps(a_max_y, _mm_loadu_ps(min_y + i)),
+                      _mm_cmpgt_ps(a_min_y, _mm_loadu_ps(max_y + i))));
+        separated = _mm_or_ps(separated,
+            _mm_or_ps(_mm_cmplt_ps(a_max_z, _mm_loadu_ps(min_z + i)),
+                      _mm_cmpgt_ps(a_min_z, _mm_loadu_ps(max_z + i))));
+        hits |= (~(uint32_t)_mm_movemask_ps(separated) & 0xFu) << i;
+    }
+#endif
+
+    // Caixas restantes (ou todas, sem SIMD)
+    for (; i < count; ++i) {
+        bool separated =
+            box.max.x < min_x[i] || box.min.x > max_x[i] ||
+            box.max.y < min_y[i] || box.min.y > max_y[i] ||
+            box.max.z < min_z[i] || box.min.z > max_z[i];
+        if (!separated)
+            hits |= 1u << i;
+    }
+
+    return hits;
+}
+
 BoundingBox ComputeCarAABB(const glm::vec4& carPosition, const glm::vec3& bbox_min, const glm::vec3& bbox_max) {
     glm::vec3 pos = glm::vec3(carPosition);
 
@@ -23,6 +108,96 @@ bool CheckAABBCollisionWithPlane(const BoundingBox& box, float plane_y) {
     return box.min.y < plane_y;
 }
 
+float CalculateAABBToPlaneCollisionTime(float plane_height, float bbox_min_height, float vel) {
+    if (vel == 0.0f)
+        return std::numeric_limits<float>::infinity();
+    return (plane_height - bbox_min_height) / vel;
+}
+
+bool SweptAABB(
+    const BoundingBox& moving,
+    const glm::vec3& displacement,
+    const BoundingBox& target,
+    float* toi,
+    glm::vec3* normal
+) {
+    // Método dos "slabs": em cada eixo, calculamos o intervalo de tempo em
+    // que as projeções das caixas se sobrepõem. As caixas se tocam na
+    // interseção dos três intervalos.
+    float t_enter = -std::numeric_limits<float>::infinity();
+    float t_exit  =  std::numeric_limits<float>::infinity();
+    int   axis    = -1;
+
+    for (int i = 0; i < 3; ++i) {
+        float d = displacement[i];
+        if (d == 0.0f) {
+            // Sem movimento neste eixo: as projeções precisam já se sobrepor
+            if (moving.max[i] < target.min[i] || moving.min[i] > target.max[i])
+                return false;
+            continue;
+        }
+
+        // Face da frente encontra a face oposta do alvo; face de trás sai dele
+        float enter = d > 0.0f ? CalculateAABBToPlaneCollisionTime(target.min[i], moving.max[i], d)
+                               : CalculateAABBToPlaneCollisionTime(target.max[i], moving.min[i], d);
+        float exit  = d > 0.0f ? CalculateAABBToPlaneCollisionTime(target.max[i], moving.min[i], d)
+                               : CalculateAABBToPlaneCollisionTime(target.min[i], moving.max[i], d);
+
+        if (enter > t_enter) {
+            t_enter = enter;
+            axis    = i;
+        }
+        t_exit = std::min(t_exit, exit);
+    }
+
+    if (axis < 0 || t_enter > t_exit || t_enter < 0.0f || t_enter > 1.0f)
+        return false;
+
+    *toi = t_enter;
+    *normal = glm::vec3(0.0f);
+    (*normal)[axis] = displacement[axis] > 0.0f ? -1.0f : 1.0f;
+    return true;
+}
+
+// Empurra o carro para fora da AABB de um obstáculo com o qual ele colide
+static void ResolveCarBoxOverlap(
+    glm::vec4& carPos,
+    const glm::vec4& previousCarPos,
+    const BoundingBox& currentBox,
+    const BoundingBox& wallBox,
+    float& carSpeed
+) {
+    glm::vec3 overlap(0.0f);
+
+    if (currentBox.max.x > wallBox.min.x && currentBox.min.x < wallBox.max.x) {
+        float overlapX1 = wallBox.max.x - currentBox.min.x;
+        float overlapX2 = currentBox.max.x - wallBox.min.x;
+        overlap.x = (overlapX1 < overlapX2 ? -overlapX1 : overlapX2);
+    }
+
+    if (currentBox.max.z > wallBox.min.z && currentBox.min.z < wallBox.max.z) {
+        float overlapZ1 = wallBox.max.z - currentBox.min.z;
+        float overlapZ2 = currentBox.max.z - wallBox.min.z;
+        overlap.z = (overlapZ1 < overlapZ2 ? -overlapZ1 : overlapZ2);
+    }
+
+    
+    if (std::abs(overlap.x) < std::abs(overlap.z)) {
+        overlap.z = 0;
+    } else {
+        overlap.x = 0;
+    }
+
+    // Aplica correção de colisão
+    carPos += glm::vec4(overlap, 0.0f);
+
+    // Aplica empurrão adicional na direção oposta ao movimento
+    glm::vec3 pushDir = glm::normalize(glm::vec3(previousCarPos - carPos));
+    float pushStrength = 0.3f; 
+    carPos += glm::vec4(pushDir * pushStrength, 0.0f);
+    carSpeed = 0.0f;
+}
+
 bool ResolveCarWallCollision(
     glm::vec4& carPos,
     const glm::vec4& previousCarPos,
@@ -42,41 +217,374 @@ bool ResolveCarWallCollision(
         BoundingBox wallBox = { wall_min, wall_max };
 
         if (CheckAABBCollision(currentBox, wallBox)) {
-           
-            glm::vec3 overlap(0.0f);
+            ResolveCarBoxOverlap(carPos, previousCarPos, currentBox, wallBox, carSpeed);
+            return true;
+        }
+    }
+
+    return false;
+}
 
-            if (currentBox.max.x > wallBox.min.x && currentBox.min.x < wallBox.max.x) {
-                float overlapX1 = wallBox.max.x - currentBox.min.x;
-                float overlapX2 = currentBox.max.x - wallBox.min.x;
-                overlap.x = (overlapX1 < overlapX2 ? -overlapX1 : overlapX2);
+// Intervalo de células [*first, *last] da grade ocupado por [min, max] em um
+// eixo. Retorna false se o intervalo está inteiramente fora da grade.
+static bool CellRange(float min, float max, float origin, float cell_size, int cells, int* first, int* last) {
+    float f = std::floor((min - origin) / cell_size);
+    float l = std::floor((max - origin) / cell_size);
+    if (!(l >= 0.0f) || !(f < (float)cells))
+        return false;
+    *first = (int)std::max(f, 0.0f);
+    *last  = (int)std::min(l, (float)(cells - 1));
+    return true;
+}
+
+void BuildStaticColliderGrid(
+    StaticColliderGrid* grid,
+    const std::vector<glm::vec3>& positions,
+    const glm::vec3& bbox_min,
+    const glm::vec3& bbox_max,
+    const glm::vec3& scale,
+    float cell_size
+) {
+    grid->boxes.resize(positions.size());
+    grid->cell_size = cell_size;
+    grid->origin    = glm::vec2(0.0f);
+    grid->cells_x   = 0;
+    grid->cells_z   = 0;
+    grid->cell_start.assign(1, 0);
+    grid->items.clear();
+    grid->cell_boxes = BoundingBoxArray();
+
+    if (positions.empty())
+        return;
+
+    // Mesma conta feita por ResolveCarWallCollision(), para que as AABBs
+    // sejam idênticas às da busca linear.
+    glm::vec2 world_min( std::numeric_limits<float>::max());
+    glm::vec2 world_max(-std::numeric_limits<float>::max());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        BoundingBox& box = grid->boxes[i];
+        box.min = bbox_min * scale + positions[i];
+        box.max = bbox_max * scale + positions[i];
+        world_min = glm::min(world_min, glm::vec2(box.min.x, box.min.z));
+        world_max = glm::max(world_max, glm::vec2(box.max.x, box.max.z));
+    }
+
+    grid->origin  = world_min;
+    grid->cells_x = std::max(1, (int)std::ceil((world_max.x - world_min.x) / cell_size));
+    grid->cells_z = std::max(1, (int)std::ceil((world_max.y - world_min.y) / cell_size));
+
+    // Counting sort dos obstáculos por célula: primeiro contamos quantos
+    // obstáculos ocupam cada célula, depois preenchemos "items". Como os
+    // obstáculos são percorridos em ordem, os índices de cada célula ficam
+    // em ordem crescente.
+    size_t num_cells = (size_t)grid->cells_x * grid->cells_z;
+    std::vector<uint32_t> counts(num_cells + 1, 0);
+
+    for (int pass = 0; pass < 2; ++pass) {
+        for (size_t i = 0; i < grid->boxes.size(); ++i) {
+            const BoundingBox& box = grid->boxes[i];
+            int x0, x1, z0, z1;
+            if (!CellRange(box.min.x, box.max.x, grid->origin.x, cell_size, grid->cells_x, &x0, &x1) ||
+                !CellRange(box.min.z, box.max.z, grid->origin.y, cell_size, grid->cells_z, &z0, &z1))
+                continue;
+
+            for (int z = z0; z <= z1; ++z) {
+                for (int x = x0; x <= x1; ++x) {
+                    size_t cell = (size_t)z * grid->cells_x + x;
+                    if (pass == 0)
+                        counts[cell + 1] += 1;
+                    else
+                        grid->items[counts[cell]++] = (uint32_t)i;
+                }
             }
+        }
+
+        if (pass == 0) {
+            for (size_t c = 0; c < num_cells; ++c)
+                counts[c + 1] += counts[c];
+            grid->cell_start = counts;
+            grid->items.resize(counts[num_cells]);
+        }
+    }
+
+    // Cópia das AABBs na ordem das células, para o teste em lote
+    for (size_t k = 0; k < grid->items.size(); ++k)
+        AppendBoundingBox(&grid->cell_boxes, grid->boxes[grid->items[k]]);
+}
+
+OrientedBoundingBox ComputeCarOBB(const glm::vec4& carPosition, float carYaw, const glm::vec3& bbox_min, const glm::vec3& bbox_max) {
+    // Mesma rotação usada na renderização: Matrix_Rotate_Y(carYaw)
+    float c = std::cos(carYaw);
+    float s = std::sin(carYaw);
+
+    OrientedBoundingBox box;
+    box.axes[0] = glm::vec3(   c, 0.0f,   -s);
+    box.axes[1] = glm::vec3(0.0f, 1.0f, 0.0f);
+    box.axes[2] = glm::vec3(   s, 0.0f,    c);
+    box.half_extents = (bbox_max - bbox_min) * 0.5f;
+
+    glm::vec3 local_center = (bbox_min + bbox_max) * 0.5f;
+    box.center = glm::vec3(carPosition)
+               + box.axes[0] * local_center.x
+               + box.axes[1] * local_center.y
+               + box.axes[2] * local_center.z;
+    return box;
+}
+
+OrientedBoundingBox OBBFromAABB(const BoundingBox& box) {
+    OrientedBoundingBox obb;
+    obb.center       = (box.min + box.max) * 0.5f;
+    obb.half_extents = (box.max - box.min) * 0.5f;
+    obb.axes[0] = glm::vec3(1.0f, 0.0f, 0.0f);
+    obb.axes[1] = glm::vec3(0.0f, 1.0f, 0.0f);
+    obb.axes[2] = glm::vec3(0.0f, 0.0f, 1.0f);
+    return obb;
+}
+
+BoundingBox OBBBounds(const OrientedBoundingBox& box) {
+    glm::vec3 extent = glm::abs(box.axes[0]) * box.half_extents.x
+                     + glm::abs(box.axes[1]) * box.half_extents.y
+                     + glm::abs(box.axes[2]) * box.half_extents.z;
+    BoundingBox bounds = { box.center - extent, box.center + extent };
+    return bounds;
+}
+
+// Raio da projeção de uma OBB sobre o eixo "axis"
+static float ProjectedRadius(const OrientedBoundingBox& box, const glm::vec3& axis) {
+    return std::abs(glm::dot(box.axes[0], axis)) * box.half_extents.x
+         + std::abs(glm::dot(box.axes[1], axis)) * box.half_extents.y
+         + std::abs(glm::dot(box.axes[2], axis)) * box.half_extents.z;
+}
+
+// Eixos candidatos do teorema do eixo separador (SAT) para duas OBBs: os 3
+// eixos de cada caixa e os produtos vetoriais entre eles, normalizados.
+// Produtos de eixos paralelos são descartados. Retorna o número de eixos.
+static int SeparatingAxes(const OrientedBoundingBox& a, const OrientedBoundingBox& b, glm::vec3 axes[15]) {
+    int count = 0;
+    for (int i = 0; i < 3; ++i) {
+        axes[count++] = a.axes[i];
+        axes[count++] = b.axes[i];
+    }
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            glm::vec3 axis = glm::cross(a.axes[i], b.axes[j]);
+            float length2 = glm::dot(axis, axis);
+            if (length2 > 1e-6f)
+                axes[count++] = axis / std::sqrt(length2);
+        }
+    }
+    return count;
+}
+
+// Teste SAT comum a CheckOBBCollision() e CheckOBBAABBCollisionXZ(). Todos
+// os eixos são usados para detectar a separação; com "horizontal" o contato
+// de menor penetração é procurado somente entre direções do plano XZ: cada
+// eixo é projetado no plano e a profundidade é convertida para um
+// deslocamento ao longo dessa projeção. Eixos (quase) verticais não geram
+// contato; se nenhum eixo servir, a normal retornada é nula.
+static bool CheckOBBCollisionAxes(const OrientedBoundingBox& a, const OrientedBoundingBox& b, bool horizontal, CollisionContact* contact) {
+    glm::vec3 axes[15];
+    int num_axes = SeparatingAxes(a, b, axes);
+    glm::vec3 offset = a.center - b.center;
+
+    CollisionContact best;
+    best.normal = glm::vec3(0.0f);
+    best.depth  = std::numeric_limits<float>::max();
+    for (int i = 0; i < num_axes; ++i) {
+        float distance = glm::dot(offset, axes[i]);
+        float depth = ProjectedRadius(a, axes[i]) + ProjectedRadius(b, axes[i]) - std::abs(distance);
+        if (depth < 0.0f)
+            return false; // Eixo separador encontrado
+
+        glm::vec3 normal = axes[i];
+        if (horizontal) {
+            // Deslocar a caixa de "d" ao longo da projeção unitária do eixo
+            // no plano XZ a move de d*length ao longo do próprio eixo.
+            normal.y = 0.0f;
+            float length = glm::length(normal);
+            if (length < 1e-3f)
+                continue;
+            normal /= length;
+            depth  /= length;
+        }
 
-            if (currentBox.max.z > wallBox.min.z && currentBox.min.z < wallBox.max.z) {
-                float overlapZ1 = wallBox.max.z - currentBox.min.z;
-                float overlapZ2 = currentBox.max.z - wallBox.min.z;
-                overlap.z = (overlapZ1 < overlapZ2 ? -overlapZ1 : overlapZ2);
+        if (depth < best.depth) {
+            best.depth  = depth;
+            best.normal = distance < 0.0f ? -normal : normal;
+        }
+    }
+
+    if (contact != NULL)
+        *contact = best;
+    return true;
+}
+
+bool CheckOBBCollision(const OrientedBoundingBox& a, const OrientedBoundingBox& b, CollisionContact* contact) {
+    return CheckOBBCollisionAxes(a, b, false, contact);
+}
+
+bool CheckOBBAABBCollision(const OrientedBoundingBox& a, const BoundingBox& b, CollisionContact* contact) {
+    return CheckOBBCollision(a, OBBFromAABB(b), contact);
+}
+
+bool CheckOBBAABBCollisionXZ(const OrientedBoundingBox& a, const BoundingBox& b, CollisionContact* contact) {
+    return CheckOBBCollisionAxes(a, OBBFromAABB(b), true, contact);
+}
+
+bool SweptOBB(
+    const OrientedBoundingBox& moving,
+    const glm::vec3& displacement,
+    const OrientedBoundingBox& target,
+    float* toi,
+    glm::vec3* normal
+) {
+    // Mesmo método de SweptAABB(), aplicado aos eixos do SAT: as caixas
+    // se sobrepõem exatamente quando suas projeções se sobrepõem em todos
+    // os eixos, portanto o contato ocorre na interseção dos intervalos de
+    // tempo de cada eixo.
+    glm::vec3 axes[15];
+    int num_axes = SeparatingAxes(moving, target, axes);
+    glm::vec3 offset = moving.center - target.center;
+
+    float t_enter = -std::numeric_limits<float>::infinity();
+    float t_exit  =  std::numeric_limits<float>::infinity();
+    int   entry_axis = -1;
+
+    for (int i = 0; i < num_axes; ++i) {
+        float radius   = ProjectedRadius(moving, axes[i]) + ProjectedRadius(target, axes[i]);
+        float distance = glm::dot(offset, axes[i]);
+        float velocity = glm::dot(displacement, axes[i]);
+
+        if (std::abs(velocity) < 1e-7f) {
+            if (std::abs(distance) > radius)
+                return false;
+            continue;
+        }
+
+        float t0 = CalculateAABBToPlaneCollisionTime(-radius, distance, velocity);
+        float t1 = CalculateAABBToPlaneCollisionTime( radius, distance, velocity);
+        if (t0 > t1)
+            std::swap(t0, t1);
+
+        if (t0 > t_enter) {
+            t_enter    = t0;
+            entry_axis = i;
+        }
+        t_exit = std::min(t_exit, t1);
+    }
+
+    if (entry_axis < 0 || t_enter > t_exit || t_enter < 0.0f || t_enter > 1.0f)
+        return false;
+
+    *toi = t_enter;
+    *normal = glm::dot(displacement, axes[entry_axis]) > 0.0f ? -axes[entry_axis] : axes[entry_axis];
+    return true;
+}
+
+// Chama visit(i) para cada obstáculo i da grade cuja AABB colide com "box".
+// Um obstáculo que ocupa várias células pode ser visitado mais de uma vez.
+template <typename Visitor>
+static void VisitGridCandidates(const StaticColliderGrid& grid, const BoundingBox& box, Visitor visit) {
+    int x0, x1, z0, z1;
+    if (!CellRange(box.min.x, box.max.x, grid.origin.x, grid.cell_size, grid.cells_x, &x0, &x1) ||
+        !CellRange(box.min.z, box.max.z, grid.origin.y, grid.cell_size, grid.cells_z, &z0, &z1))
+        return;
+
+    for (int z = z0; z <= z1; ++z) {
+        for (int x = x0; x <= x1; ++x) {
+            size_t cell = (size_t)z * grid.cells_x + x;
+            size_t end  = grid.cell_start[cell + 1];
+            for (size_t k = grid.cell_start[cell]; k < end; k += AABB_BATCH_SIZE) {
+                size_t count = std::min(end - k, (size_t)AABB_BATCH_SIZE);
+                uint32_t mask = CheckAABBCollisionBatch(box, grid.cell_boxes, k, count);
+                for (size_t b = 0; mask != 0; ++b, mask >>= 1) {
+                    if (mask & 1u)
+                        visit(grid.items[k + b]);
+                }
             }
+        }
+    }
+}
 
-            
-            if (std::abs(overlap.x) < std::abs(overlap.z)) {
-                overlap.z = 0;
-            } else {
-                overlap.x = 0;
+bool ResolveCarStaticCollision(
+    glm::vec4& carPos,
+    float carYaw,
+    const glm::vec3& car_bbox_min,
+    const glm::vec3& car_bbox_max,
+    float& carSpeed,
+    const StaticColliderGrid& grid
+) {
+    // Folga deixada entre o carro e o obstáculo após a correção
+    const float CONTACT_SKIN = 0.001f;
+
+    // Cada iteração empurra o carro para fora do obstáculo de maior
+    // penetração; um carro encostado em dois obstáculos (por exemplo, no
+    // encontro de dois guard rails) precisa de mais de uma.
+    const int MAX_ITERATIONS = 4;
+
+    bool hit = false;
+    for (int iteration = 0; iteration < MAX_ITERATIONS; ++iteration) {
+        OrientedBoundingBox carBox = ComputeCarOBB(carPos, carYaw, car_bbox_min, car_bbox_max);
+
+        // Somente correções horizontais: a gravidade e o chão cuidam da
+        // altura do carro, e um empurrão para cima (por exemplo, sobre as
+        // paredes baixas da chegada) seria desfeito no passo seguinte.
+        bool found = false;
+        CollisionContact deepest;
+        VisitGridCandidates(grid, OBBBounds(carBox), [&](uint32_t i) {
+            CollisionContact contact;
+            if (CheckOBBAABBCollisionXZ(carBox, grid.boxes[i], &contact) &&
+                contact.normal != glm::vec3(0.0f) &&
+                (!found || contact.depth > deepest.depth)) {
+                found   = true;
+                deepest = contact;
             }
+        });
 
-            // Aplica correção de colisão
-            carPos += glm::vec4(overlap, 0.0f);
+        if (!found)
+            break;
 
-            // Aplica empurrão adicional na direção oposta ao movimento
-            glm::vec3 pushDir = glm::normalize(glm::vec3(previousCarPos - carPos));
-            float pushStrength = 0.3f; 
-            carPos += glm::vec4(pushDir * pushStrength, 0.0f);
-            carSpeed = 0.0f;
-            return true;
-        }
+        carPos += glm::vec4(deepest.normal * (deepest.depth + CONTACT_SKIN), 0.0f);
+        hit = true;
     }
 
-    return false;
+    if (hit)
+        carSpeed = 0.0f;
+    return hit;
+}
+
+bool SweepCarStaticColliders(
+    const glm::vec4& from,
+    const glm::vec4& to,
+    float carYaw,
+    const glm::vec3& car_bbox_min,
+    const glm::vec3& car_bbox_max,
+    const StaticColliderGrid& grid,
+    float* toi,
+    glm::vec3* normal
+) {
+    OrientedBoundingBox startBox = ComputeCarOBB(from, carYaw, car_bbox_min, car_bbox_max);
+    glm::vec3 displacement = glm::vec3(to - from);
+
+    // AABB de todo o trajeto: filtra os candidatos com o teste em lote
+    BoundingBox startBounds = OBBBounds(startBox);
+    BoundingBox sweptBox;
+    sweptBox.min = glm::min(startBounds.min, startBounds.min + displacement);
+    sweptBox.max = glm::max(startBounds.max, startBounds.max + displacement);
+
+    bool hit = false;
+    VisitGridCandidates(grid, sweptBox, [&](uint32_t i) {
+        float t;
+        glm::vec3 n;
+        if (SweptOBB(startBox, displacement, OBBFromAABB(grid.boxes[i]), &t, &n) &&
+            (!hit || t < *toi)) {
+            hit     = true;
+            *toi    = t;
+            *normal = n;
+        }
+    });
+
+    return hit;
 }
 
 void ResolveCarGroundCollision(
@@ -0,0 +1,168 @@
+#include "culling.h"
+
+#include <algorithm>
+#include <cmath>
+
+Frustum ExtractFrustumPlanes(const glm::mat4& view_projection)
+{
+    // glm guarda as matrizes por colunas: a linha i é (m[0][i], m[1][i], m[2][i], m[3][i]).
+    const glm::mat4& m = view_projection;
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    // Um ponto está dentro do volume de recorte se -w <= x,y,z <= w. Cada
+    // uma destas seis desigualdades define um plano.
+    Frustum frustum;
+    frustum.planes[0] = row3 + row0; // Esquerda
+    frustum.planes[1] = row3 - row0; // Direita
+    frustum.planes[2] = row3 + row1; // Baixo
+    frustum.planes[3] = row3 - row1; // Cima
+    frustum.planes[4] = row3 + row2; // Near
+    frustum.planes[5] = row3 - row2; // Far
+
+    for (int i = 0; i < 6; ++i)
+    {
+        float length = glm::length(glm::vec3(frustum.planes[i]));
+        if ( length > 0.0f )
+            frustum.planes[i] /= length;
+    }
+
+    return frustum;
+}
+
+bool FrustumIntersectsAABB(const Frustum& frustum, const BoundingBox& box)
+{
+    for (int i = 0; i < 6; ++i)
+    {
+        const glm::vec4& plane = frustum.planes[i];
+
+        // Vértice da AABB mais distante na direção da normal do plano. Se nem
+        // ele está do lado de dentro, a caixa inteira está fora.
+        glm::vec3 p(
+            plane.x >= 0.0f ? box.max.x : box.min.x,
+            plane.y >= 0.0f ? box.max.y : box.min.y,
+            plane.z >= 0.0f ? box.max.z : box.min.z
+        );
+
+        if ( glm::dot(glm::vec3(plane), p) + plane.w < 0.0f )
+            return false;
+    }
+    return true;
+}
+
+BoundingBox TransformAABB(const glm::mat4& model, const glm::vec3& bbox_min, const glm::vec3& bbox_max)
+{
+    // Método de Arvo: o centro é transformado normalmente e a meia-extensão
+    // pelo valor absoluto da parte linear da matriz.
+    glm::vec3 center = (bbox_min + bbox_max) * 0.5f;
+    glm::vec3 extent = (bbox_max - bbox_min) * 0.5f;
+
+    glm::vec3 world_center = glm::vec3(model * glm::vec4(center, 1.0f));
+    glm::vec3 world_extent(0.0f);
+    for (int column = 0; column < 3; ++column)
+        world_extent += glm::abs(glm::vec3(model[column])) * extent[column];
+
+    BoundingBox box;
+    box.min = world_center - world_extent;
+    box.max = world_center + world_extent;
+    return box;
+}
+
+void InstanceGrid_Build(InstanceGrid* grid, const std::vector<glm::mat4>& models,
+                        const glm::vec3& bbox_min, const glm::vec3& bbox_max, float cell_size)
+{
+    grid->cell_size = cell_size;
+    grid->instance_bounds.resize(models.size());
+    grid->items.clear();
+    grid->cell_start.clear();
+    grid->cell_bounds.clear();
+
+    if ( models.empty() )
+    {
+        grid->origin = glm::vec2(0.0f);
+        grid->cells_x = grid->cells_z = 0;
+        grid->cell_start.push_back(0);
+        return;
+    }
+
+    glm::vec2 lo( INFINITY,  INFINITY);
+    glm::vec2 hi(-INFINITY, -INFINITY);
+    for (size_t i = 0; i < models.size(); ++i)
+    {
+        BoundingBox box = TransformAABB(models[i], bbox_min, bbox_max);
+        grid->instance_bounds[i] = box;
+
+        glm::vec2 center = glm::vec2(box.min.x + box.max.x, box.min.z + box.max.z) * 0.5f;
+        lo = glm::min(lo, center);
+        hi = glm::max(hi, center);
+    }
+
+    grid->origin  = lo;
+    grid->cells_x = (int)std::floor((hi.x - lo.x) / cell_size) + 1;
+    grid->cells_z = (int)std::floor((hi.y - lo.y) / cell_size) + 1;
+
+    const size_t num_cells = (size_t)grid->cells_x * grid->cells_z;
+
+    // Ordenação por contagem ("counting sort") das instâncias por célula
+    std::vector<uint32_t> cell_of(models.size());
+    grid->cell_start.assign(num_cells + 1, 0);
+    for (size_t i = 0; i < models.size(); ++i)
+    {
+        const BoundingBox& box = grid->instance_bounds[i];
+        int cx = (int)((0.5f*(box.min.x + box.max.x) - lo.x) / cell_size);
+        int cz = (int)((0.5f*(box.min.z + box.max.z) - lo.y) / cell_size);
+        cx = std::min(std::max(cx, 0), grid->cells_x - 1);
+        cz = std::min(std::max(cz, 0), grid->cells_z - 1);
+        cell_of[i] = (uint32_t)(cz * grid->cells_x + cx);
+        grid->cell_start[cell_of[i] + 1] += 1;
+    }
+    for (size_t c = 0; c < num_cells; ++c)
+        grid->cell_start[c + 1] += grid->cell_start[c];
+
+    grid->items.resize(models.size());
+    std::vector<uint32_t> cursor(grid->cell_start.begin(), grid->cell_start.end() - 1);
+    for (size_t i = 0; i < models.size(); ++i)
+        grid->items[cursor[cell_of[i]]++] = (uint32_t)i;
+
+    grid->cell_bounds.resize(num_cells);
+    for (size_t c = 0; c < num_cells; ++c)
+    {
+        BoundingBox bounds;
+        bounds.min = glm::vec3( INFINITY);
+        bounds.max = glm::vec3(-INFINITY);
+        for (uint32_t k = grid->cell_start[c]; k < grid->cell_start[c + 1]; ++k)
+        {
+            const BoundingBox& box = grid->instance_bounds[grid->items[k]];
+            bounds.min = glm::min(bounds.min, box.min);
+            bounds.max = glm::max(bounds.max, box.max);
+        }
+        grid->cell_bounds[c] = bounds;
+    }
+}
+
+size_t InstanceGrid_Query(const InstanceGrid& grid, const Frustum& frustum, std::vector<uint32_t>* visible)
+{
+    size_t first = visible->size();
+    const size_t num_cells = grid.cell_bounds.size();
+
+    for (size_t c = 0; c < num_cells; ++c)
+    {
+        uint32_t begin = grid.cell_start[c];
+        uint32_t end   = grid.cell_start[c + 1];
+        if ( begin == end || !FrustumIntersectsAABB(frustum, grid.cell_bounds[c]) )
+            continue;
+
+        for (uint32_t k = begin; k < end; ++k)
+        {
+            uint32_t instance = grid.items[k];
+            if ( FrustumIntersectsAABB(frustum, grid.instance_bounds[instance]) )
+                visible->push_back(instance);
+        }
+    }
+
+    // Mantemos a ordem original das instâncias, como no desenho sem culling.
+    std::sort(visible->begin() + first, visible->end());
+    return visible->size() - first;
+}
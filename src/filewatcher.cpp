@@ -0,0 +1,88 @@
+#include "filewatcher.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+bool FileWatcher_Init(FileWatcher* watcher, const char* directory, const char* suffix)
+{
+    watcher->fd    = -1;
+    watcher->watch = -1;
+    strncpy(watcher->suffix, suffix, sizeof(watcher->suffix) - 1);
+    watcher->suffix[sizeof(watcher->suffix) - 1] = '\0';
+
+#ifdef __linux__
+    watcher->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if ( watcher->fd < 0 )
+        return false;
+
+    // Editores costumam salvar escrevendo um arquivo temporário e
+    // renomeando-o por cima do original, então além de IN_CLOSE_WRITE
+    // observamos também IN_MOVED_TO e IN_CREATE.
+    watcher->watch = inotify_add_watch(watcher->fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if ( watcher->watch < 0 )
+    {
+        fprintf(stderr, "WARNING: Cannot watch directory \"%s\".\n", directory);
+        FileWatcher_Destroy(watcher);
+        return false;
+    }
+    return true;
+#else
+    (void)directory;
+    return false;
+#endif
+}
+
+#ifdef __linux__
+static bool HasSuffix(const char* name, const char* suffix)
+{
+    size_t name_length   = strlen(name);
+    size_t suffix_length = strlen(suffix);
+    return name_length >= suffix_length && strcmp(name + name_length - suffix_length, suffix) == 0;
+}
+#endif
+
+bool FileWatcher_Poll(FileWatcher* watcher)
+{
+#ifdef __linux__
+    if ( watcher->fd < 0 )
+        return false;
+
+    // Lemos todos os eventos pendentes; vários eventos do mesmo salvamento
+    // contam como uma única mudança.
+    bool changed = false;
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    for (;;)
+    {
+        ssize_t length = read(watcher->fd, buffer, sizeof(buffer));
+        if ( length <= 0 )
+            break;
+
+        for (char* cursor = buffer; cursor < buffer + length; )
+        {
+            const struct inotify_event* event = (const struct inotify_event*)cursor;
+            if ( event->len > 0 && HasSuffix(event->name, watcher->suffix) )
+                changed = true;
+            cursor += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    return changed;
+#else
+    (void)watcher;
+    return false;
+#endif
+}
+
+void FileWatcher_Destroy(FileWatcher* watcher)
+{
+#ifdef __linux__
+    if ( watcher->fd >= 0 )
+        close(watcher->fd);
+#endif
+    watcher->fd    = -1;
+    watcher->watch = -1;
+}
@@ -0,0 +1,177 @@
+#include "geometryarena.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// Estado da arena. Existe uma única arena, compartilhada por toda a cena.
+static GLuint g_ArenaVAO            = 0;
+static GLuint g_ArenaVertexBuffer   = 0;
+static GLuint g_ArenaIndexBuffer    = 0;
+static size_t g_ArenaVertexCapacity = 0;
+static size_t g_ArenaIndexCapacity  = 0;
+static size_t g_ArenaVertexCount    = 0;
+static size_t g_ArenaIndexCount     = 0;
+
+// Aponta os atributos do VAO da arena para o VBO atual. Veja a definição de
+// PackedVertex em "mesh.h" e a decodificação em "shader_vertex.glsl".
+static void SetupVertexAttributes()
+{
+    glBindVertexArray(g_ArenaVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, g_ArenaVertexBuffer);
+
+    const GLsizei stride = sizeof(PackedVertex);
+
+    // Posição: 3 x unorm16, convertidos para [0,1] pela GPU ("normalized" = GL_TRUE)
+    GLuint location = 0; // "(location = 0)" em "shader_vertex.glsl"
+    glVertexAttribPointer(location, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, position));
+    glEnableVertexAttribArray(location);
+
+    // Normal: 2 x snorm16 (octaédrica). Enviamos os inteiros sem normalização
+    // e dividimos por 32767 no shader, pois a conversão de snorm para float
+    // mudou entre versões de OpenGL.
+    location = 1; // "(location = 1)" em "shader_vertex.glsl"
+    glVertexAttribPointer(location, 2, GL_SHORT, GL_FALSE, stride, (void*)offsetof(PackedVertex, normal));
+    glEnableVertexAttribArray(location);
+
+    // Coordenadas de textura: 2 x half-float
+    location = 2; // "(location = 2)" em "shader_vertex.glsl"
+    glVertexAttribPointer(location, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, texcoord));
+    glEnableVertexAttribArray(location);
+
+    // O EBO faz parte do estado do VAO.
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_ArenaIndexBuffer);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Cria um novo buffer com a capacidade dada (em bytes) e copia para ele os
+// primeiros "used_bytes" do buffer antigo, que é então deletado.
+static GLuint ReallocateBuffer(GLuint old_buffer, size_t used_bytes, size_t new_capacity_bytes)
+{
+    GLuint new_buffer;
+    glGenBuffers(1, &new_buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, new_buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, new_capacity_bytes, NULL, GL_STATIC_DRAW);
+
+    if ( old_buffer != 0 )
+    {
+        if ( used_bytes > 0 )
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, old_buffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used_bytes);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &old_buffer);
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    return new_buffer;
+}
+
+void GeometryArena_Init(size_t vertex_capacity, size_t index_capacity)
+{
+    GeometryArena_Destroy();
+
+    g_ArenaVertexCapacity = std::max(vertex_capacity, (size_t)1);
+    g_ArenaIndexCapacity  = std::max(index_capacity, (size_t)1);
+
+    glGenVertexArrays(1, &g_ArenaVAO);
+    g_ArenaVertexBuffer = ReallocateBuffer(0, 0, g_ArenaVertexCapacity * sizeof(PackedVertex));
+    g_ArenaIndexBuffer  = ReallocateBuffer(0, 0, g_ArenaIndexCapacity * sizeof(GLuint));
+
+    SetupVertexAttributes();
+}
+
+void GeometryArena_Destroy()
+{
+    if ( g_ArenaVAO != 0 )
+        glDeleteVertexArrays(1, &g_ArenaVAO);
+    if ( g_ArenaVertexBuffer != 0 )
+        glDeleteBuffers(1, &g_ArenaVertexBuffer);
+    if ( g_ArenaIndexBuffer != 0 )
+        glDeleteBuffers(1, &g_ArenaIndexBuffer);
+
+    g_ArenaVAO = g_ArenaVertexBuffer = g_ArenaIndexBuffer = 0;
+    g_ArenaVertexCapacity = g_ArenaIndexCapacity = 0;
+    g_ArenaVertexCount = g_ArenaIndexCount = 0;
+}
+
+GeometryRange GeometryArena_Upload(const std::vector<PackedVertex>& vertices, const std::vector<uint32_t>& indices)
+{
+    if ( g_ArenaVAO == 0 )
+        GeometryArena_Init(vertices.size(), indices.size());
+
+    // glDrawElementsBaseVertex() recebe o vértice base como GLint.
+    if ( g_ArenaVertexCount + vertices.size() > 0x7fffffff )
+        throw std::runtime_error("Geometry arena overflow");
+
+    bool attributes_changed = false;
+
+    if ( g_ArenaVertexCount + vertices.size() > g_ArenaVertexCapacity )
+    {
+        size_t capacity = g_ArenaVertexCapacity;
+        while ( capacity < g_ArenaVertexCount + vertices.size() )
+            capacity *= 2;
+        g_ArenaVertexBuffer = ReallocateBuffer(g_ArenaVertexBuffer, g_ArenaVertexCount * sizeof(PackedVertex), capacity * sizeof(PackedVertex));
+        g_ArenaVertexCapacity = capacity;
+        attributes_changed = true;
+    }
+
+    if ( g_ArenaIndexCount + indices.size() > g_ArenaIndexCapacity )
+    {
+        size_t capacity = g_ArenaIndexCapacity;
+        while ( capacity < g_ArenaIndexCount + indices.size() )
+            capacity *= 2;
+        g_ArenaIndexBuffer = ReallocateBuffer(g_ArenaIndexBuffer, g_ArenaIndexCount * sizeof(GLuint), capacity * sizeof(GLuint));
+        g_ArenaIndexCapacity = capacity;
+        attributes_changed = true;
+    }
+
+    if ( attributes_changed )
+        SetupVertexAttributes();
+
+    GeometryRange range;
+    range.base_vertex  = (GLint)g_ArenaVertexCount;
+    range.first_index  = g_ArenaIndexCount;
+    range.num_vertices = vertices.size();
+    range.num_indices  = indices.size();
+
+    // Utilizamos os alvos de cópia para não alterar o EBO ligado ao VAO atual.
+    if ( !vertices.empty() )
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, g_ArenaVertexBuffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, g_ArenaVertexCount * sizeof(PackedVertex), vertices.size() * sizeof(PackedVertex), vertices.data());
+    }
+    if ( !indices.empty() )
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, g_ArenaIndexBuffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, g_ArenaIndexCount * sizeof(GLuint), indices.size() * sizeof(GLuint), indices.data());
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    g_ArenaVertexCount += vertices.size();
+    g_ArenaIndexCount  += indices.size();
+
+    return range;
+}
+
+void GeometryArena_Bind()
+{
+    glBindVertexArray(g_ArenaVAO);
+}
+
+GLuint GeometryArena_VertexArrayObject()
+{
+    return g_ArenaVAO;
+}
+
+GLuint GeometryArena_VertexBuffer()
+{
+    return g_ArenaVertexBuffer;
+}
+
+GLuint GeometryArena_IndexBuffer()
+{
+    return g_ArenaIndexBuffer;
+}
@@ -0,0 +1,121 @@
+#include "gputimer.h"
+
+#include <algorithm>
+
+#include "profiler.h"
+
+// Peso do quadro mais recente na média exibida no HUD
+static const float GPU_TIMER_SMOOTHING = 0.1f;
+
+// Resultados acima deste valor são descartados. Alguns drivers (por exemplo
+// o llvmpipe do Mesa) retornam lixo na primeira consulta GL_TIME_ELAPSED.
+static const GLuint64 GPU_TIMER_MAX_VALID_NS = 1000000000ull;
+
+static const char* const PASS_NAMES[GPU_NUM_PASSES] = {
+    "clear", "track", "walls", "arcs", "guard rails", "people", "grandma", "cars", "text"
+};
+
+// Consultas de um quadro
+struct GpuTimerFrame
+{
+    GLuint queries[GPU_NUM_PASSES];
+    bool   issued[GPU_NUM_PASSES];    // Passe executado neste quadro
+    double cpu_start[GPU_NUM_PASSES]; // Profiler_Now() ao iniciar o passe, ou negativo
+};
+
+static GpuTimerFrame g_GpuTimerFrames[GPU_TIMER_LATENCY];
+static int           g_GpuTimerCurrentFrame = 0;
+static int           g_GpuTimerActivePass = -1;
+static bool          g_GpuTimerInitialized = false;
+static float         g_GpuTimerMilliseconds[GPU_NUM_PASSES];
+
+void GpuTimer_Init()
+{
+    for (int f = 0; f < GPU_TIMER_LATENCY; ++f)
+    {
+        glGenQueries(GPU_NUM_PASSES, g_GpuTimerFrames[f].queries);
+        for (int p = 0; p < GPU_NUM_PASSES; ++p)
+        {
+            g_GpuTimerFrames[f].issued[p] = false;
+            g_GpuTimerFrames[f].cpu_start[p] = -1.0;
+        }
+    }
+    for (int p = 0; p < GPU_NUM_PASSES; ++p)
+        g_GpuTimerMilliseconds[p] = -1.0f;
+
+    g_GpuTimerInitialized = true;
+}
+
+void GpuTimer_BeginFrame()
+{
+    if ( !g_GpuTimerInitialized )
+        return;
+
+    g_GpuTimerCurrentFrame = (g_GpuTimerCurrentFrame + 1) % GPU_TIMER_LATENCY;
+    GpuTimerFrame& frame = g_GpuTimerFrames[g_GpuTimerCurrentFrame];
+
+    // No trace, os passes de GPU aparecem em sequência a partir do momento
+    // em que foram enviados pela CPU (GL_TIME_ELAPSED mede somente a duração).
+    double gpu_cursor = 0.0;
+    for (int p = 0; p < GPU_NUM_PASSES; ++p)
+    {
+        if ( !frame.issued[p] )
+            continue;
+        frame.issued[p] = false;
+
+        GLint available = 0;
+        glGetQueryObjectiv(frame.queries[p], GL_QUERY_RESULT_AVAILABLE, &available);
+        if ( !available )
+            continue;
+
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(frame.queries[p], GL_QUERY_RESULT, &nanoseconds);
+        if ( nanoseconds > GPU_TIMER_MAX_VALID_NS )
+            continue;
+
+        float milliseconds = (float)(nanoseconds * 1e-6);
+
+        if ( g_GpuTimerMilliseconds[p] < 0.0f )
+            g_GpuTimerMilliseconds[p] = milliseconds;
+        else
+            g_GpuTimerMilliseconds[p] += GPU_TIMER_SMOOTHING * (milliseconds - g_GpuTimerMilliseconds[p]);
+
+        if ( frame.cpu_start[p] >= 0.0 && g_ProfilerEnabled )
+        {
+            double start = std::max(frame.cpu_start[p], gpu_cursor);
+            gpu_cursor = start + nanoseconds * 1e-3;
+            Profiler_RecordGPU(PASS_NAMES[p], start, gpu_cursor);
+        }
+    }
+}
+
+void GpuTimer_Begin(int pass)
+{
+    if ( !g_GpuTimerInitialized || g_GpuTimerActivePass >= 0 )
+        return;
+
+    GpuTimerFrame& frame = g_GpuTimerFrames[g_GpuTimerCurrentFrame];
+    frame.issued[pass] = true;
+    frame.cpu_start[pass] = g_ProfilerEnabled ? Profiler_Now() : -1.0;
+    glBeginQuery(GL_TIME_ELAPSED, frame.queries[pass]);
+    g_GpuTimerActivePass = pass;
+}
+
+void GpuTimer_End()
+{
+    if ( g_GpuTimerActivePass < 0 )
+        return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    g_GpuTimerActivePass = -1;
+}
+
+float GpuTimer_Milliseconds(int pass)
+{
+    return std::max(0.0f, g_GpuTimerMilliseconds[pass]);
+}
+
+const char* GpuTimer_PassName(int pass)
+{
+    return PASS_NAMES[pass];
+}
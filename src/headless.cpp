@@ -0,0 +1,272 @@
+#include "headless.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "assetloader.h"
+#include "replay.h"
+#include "simulation.h"
+
+// Entrada do script de teclas: a partir do passo "tick", as teclas "input"
+// ficam pressionadas.
+struct ScriptedInput
+{
+    uint64_t        tick;
+    SimulationInput input;
+};
+
+static bool ParseKeys(const std::string& keys, SimulationInput* input)
+{
+    *input = 0;
+    if ( keys == "-" )
+        return true;
+
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        switch (keys[i])
+        {
+            case 'W': case 'w': *input |= SIMULATION_KEY_W; break;
+            case 'A': case 'a': *input |= SIMULATION_KEY_A; break;
+            case 'S': case 's': *input |= SIMULATION_KEY_S; break;
+            case 'D': case 'd': *input |= SIMULATION_KEY_D; break;
+            default: return false;
+        }
+    }
+    return true;
+}
+
+static bool LoadScript(const char* filename, std::vector<ScriptedInput>* script)
+{
+    std::ifstream file(filename);
+    if ( !file )
+    {
+        fprintf(stderr, "ERROR: Cannot open script file \"%s\".\n", filename);
+        return false;
+    }
+
+    std::string line;
+    int line_number = 0;
+    while ( std::getline(file, line) )
+    {
+        line_number += 1;
+        if ( line.empty() || line[0] == '#' )
+            continue;
+
+        std::istringstream fields(line);
+        ScriptedInput entry;
+        std::string keys;
+        if ( !(fields >> entry.tick >> keys) || !ParseKeys(keys, &entry.input) )
+        {
+            fprintf(stderr, "ERROR: Invalid script line %d in \"%s\".\n", line_number, filename);
+            return false;
+        }
+        if ( !script->empty() && entry.tick < script->back().tick )
+        {
+            fprintf(stderr, "ERROR: Script ticks must be increasing (line %d).\n", line_number);
+            return false;
+        }
+        script->push_back(entry);
+    }
+    return true;
+}
+
+// Teclas pressionadas no passo "tick" de acordo com o script
+static SimulationInput ScriptInputAt(const std::vector<ScriptedInput>& script, size_t* cursor, uint64_t tick)
+{
+    while ( *cursor + 1 < script.size() && script[*cursor + 1].tick <= tick )
+        *cursor += 1;
+    if ( script.empty() || script[*cursor].tick > tick )
+        return 0;
+    return script[*cursor].input;
+}
+
+int Headless_Run(int argc, char* argv[])
+{
+    int    races      = 1;
+    int    difficulty = 1;
+    double max_time   = 300.0;
+    const char* script_filename = NULL;
+    const char* replay_filename = NULL;
+    const char* record_filename = NULL;
+
+    for (int i = 2; i < argc; ++i)
+    {
+        bool has_value = i + 1 < argc;
+        if ( strcmp(argv[i], "--races") == 0 && has_value )
+            races = atoi(argv[++i]);
+        else if ( strcmp(argv[i], "--difficulty") == 0 && has_value )
+            difficulty = atoi(argv[++i]);
+        else if ( strcmp(argv[i], "--script") == 0 && has_value )
+            script_filename = argv[++i];
+        else if ( strcmp(argv[i], "--max-time") == 0 && has_value )
+            max_time = atof(argv[++i]);
+        else if ( strcmp(argv[i], "--replay") == 0 && has_value )
+            replay_filename = argv[++i];
+        else if ( strcmp(argv[i], "--record") == 0 && has_value )
+            record_filename = argv[++i];
+        else
+        {
+            fprintf(stderr, "ERROR: Unknown headless option \"%s\".\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if ( races < 1 || difficulty < 0 || difficulty > 2 || max_time <= 0.0 )
+    {
+        fprintf(stderr, "ERROR: Invalid headless options.\n");
+        return EXIT_FAILURE;
+    }
+
+    Replay replay;
+    Replay_Init(&replay);
+    if ( replay_filename != NULL )
+    {
+        if ( !Replay_Load(replay_filename, &replay) )
+            return EXIT_FAILURE;
+        difficulty = replay.difficulty_level;
+    }
+
+    std::vector<ScriptedInput> script;
+    if ( script_filename != NULL )
+    {
+        if ( !LoadScript(script_filename, &script) )
+            return EXIT_FAILURE;
+    }
+    else
+    {
+        ScriptedInput hold_w = { 0, SIMULATION_KEY_W };
+        script.push_back(hold_w);
+    }
+
+    // Carregamos somente as malhas cujas bounding boxes a simulação utiliza,
+    // na mesma ordem do modo com janela, de forma que objetos com nomes
+    // repetidos resolvam para a mesma shape.
+    std::map<std::string, MeshShape> shapes;
+    {
+        AssetLoader loader;
+        loader.AddMesh("../data/track.obj", TRACK_PLANE_SCALE);
+        loader.AddMesh("../data/car.obj");
+        loader.AddMesh("../data/wall.obj");
+        loader.AddMesh("../data/guardRail.obj");
+        loader.AddMesh("../data/car_pc.obj");
+        loader.Wait();
+
+        for (size_t i = 0; i < loader.meshes.size(); ++i)
+        {
+            if ( !loader.meshes[i].error.empty() )
+            {
+                fprintf(stderr, "ERROR: %s\n", loader.meshes[i].error.c_str());
+                return EXIT_FAILURE;
+            }
+            const std::vector<MeshShape>& mesh_shapes = loader.meshes[i].mesh.shapes;
+            for (size_t s = 0; s < mesh_shapes.size(); ++s)
+                shapes[mesh_shapes[s].name] = mesh_shapes[s];
+        }
+    }
+
+    TrackColliders track;
+    Simulation_BuildTrack(&track,
+        [&shapes](const char* name, glm::vec3* bbox_min, glm::vec3* bbox_max) {
+            std::map<std::string, MeshShape>::const_iterator it = shapes.find(name);
+            *bbox_min = it != shapes.end() ? it->second.bbox_min : glm::vec3(0.0f);
+            *bbox_max = it != shapes.end() ? it->second.bbox_max : glm::vec3(0.0f);
+        },
+        glm::vec3(0.0f, 0.0f, 0.0f));
+
+    const uint64_t max_ticks = (uint64_t)(max_time * SIMULATION_HZ);
+    int wins[3] = { 0, 0, 0 };
+    uint64_t total_ticks = 0;
+    bool checksum_ok = true;
+
+    // Gravação da primeira corrida
+    Replay recording;
+    Replay_Init(&recording);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (int race = 0; race < races; ++race)
+    {
+        SimulationState state;
+        Simulation_Init(&state, track);
+
+        // Com um replay, a corrida segue exatamente os passos gravados
+        // (inclusive após a chegada) e a dificuldade é escolhida no passo
+        // em que foi escolhida na gravação.
+        if ( replay_filename == NULL )
+        {
+            Simulation_ChooseDifficulty(&state, difficulty);
+            if ( race == 0 )
+                Replay_RecordDifficulty(&recording, state);
+        }
+
+        size_t cursor = 0;
+        int winner = RACE_WINNER_NONE;
+        while ( true )
+        {
+            SimulationInput input;
+            if ( replay_filename != NULL )
+            {
+                if ( Replay_Finished(replay, state) )
+                    break;
+                input = Replay_InputForStep(replay, &state);
+            }
+            else
+            {
+                if ( winner != RACE_WINNER_NONE || state.tick >= max_ticks )
+                    break;
+                input = ScriptInputAt(script, &cursor, state.tick);
+            }
+
+            if ( race == 0 )
+                Replay_RecordStep(&recording, state, input);
+
+            Simulation_Step(&state, input, track, SIMULATION_TIMESTEP);
+            if ( winner == RACE_WINNER_NONE )
+                winner = Simulation_Winner(state);
+        }
+
+        if ( race == 0 )
+            recording.final_checksum = Replay_Checksum(state);
+        if ( replay_filename != NULL && Replay_Checksum(state) != replay.final_checksum )
+            checksum_ok = false;
+
+        wins[winner] += 1;
+        total_ticks += state.tick;
+
+        if ( race == 0 )
+        {
+            static const char* winner_names[] = { "none", "player", "pc" };
+            printf("race 0: winner=%s ticks=%llu race_time=%.3fs player_z=%.3f pc_z=%.3f\n",
+                   winner_names[winner], (unsigned long long)state.tick, state.race_time,
+                   state.car_pos.z, state.car_pos_pc.z);
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("races=%d difficulty=%d player_wins=%d pc_wins=%d unfinished=%d\n",
+           races, difficulty, wins[RACE_WINNER_PLAYER], wins[RACE_WINNER_PC], wins[RACE_WINNER_NONE]);
+    printf("steps=%llu wall_time=%.3fs races_per_second=%.1f steps_per_second=%.0f\n",
+           (unsigned long long)total_ticks, seconds,
+           seconds > 0.0 ? races / seconds : 0.0,
+           seconds > 0.0 ? total_ticks / seconds : 0.0);
+
+    if ( replay_filename != NULL )
+    {
+        printf("replay checksum: %s\n", checksum_ok ? "OK" : "MISMATCH");
+        if ( !checksum_ok )
+            return EXIT_FAILURE;
+    }
+
+    if ( record_filename != NULL && !Replay_Save(record_filename, recording) )
+        return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
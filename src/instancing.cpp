@@ -0,0 +1,88 @@
+#include "instancing.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+static GLuint g_InstanceBuffer         = 0;
+static size_t g_InstanceBufferCapacity = 0; // Em número de matrizes
+static size_t g_InstanceCount          = 0; // Matrizes já enviadas no quadro atual
+
+// Capacidade inicial do VBO de instâncias (em número de matrizes)
+static const size_t INITIAL_INSTANCE_CAPACITY = 1024;
+
+void Instancing_Init()
+{
+    glGenBuffers(1, &g_InstanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, g_InstanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, INITIAL_INSTANCE_CAPACITY * sizeof(glm::mat4), NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    g_InstanceBufferCapacity = INITIAL_INSTANCE_CAPACITY;
+    g_InstanceCount = 0;
+
+    // Valor utilizado pelo shader quando os arrays de instância estão
+    // desligados: a matriz identidade, uma coluna por location.
+    for (int column = 0; column < 4; ++column)
+    {
+        glm::vec4 value(0.0f);
+        value[column] = 1.0f;
+        glVertexAttrib4fv(INSTANCE_MODEL_LOCATION + column, glm::value_ptr(value));
+    }
+}
+
+void Instancing_BeginFrame()
+{
+    // "Orphaning": pedimos um novo armazenamento para o buffer, de forma que
+    // o driver não precise esperar a GPU terminar os desenhos do quadro
+    // anterior antes de aceitarmos novas matrizes.
+    glBindBuffer(GL_ARRAY_BUFFER, g_InstanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, g_InstanceBufferCapacity * sizeof(glm::mat4), NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    g_InstanceCount = 0;
+}
+
+size_t Instancing_Upload(const glm::mat4* matrices, size_t count)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, g_InstanceBuffer);
+
+    if ( g_InstanceCount + count > g_InstanceBufferCapacity )
+    {
+        // Os desenhos já feitos neste quadro continuam utilizando o
+        // armazenamento antigo, então podemos simplesmente começar um novo
+        // buffer, maior, a partir da posição zero.
+        while ( g_InstanceBufferCapacity < count )
+            g_InstanceBufferCapacity *= 2;
+        glBufferData(GL_ARRAY_BUFFER, g_InstanceBufferCapacity * sizeof(glm::mat4), NULL, GL_STREAM_DRAW);
+        g_InstanceCount = 0;
+    }
+
+    size_t first_instance = g_InstanceCount;
+    glBufferSubData(GL_ARRAY_BUFFER, first_instance * sizeof(glm::mat4), count * sizeof(glm::mat4), matrices);
+    g_InstanceCount += count;
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return first_instance;
+}
+
+void Instancing_EnableAttributes(size_t first_instance)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, g_InstanceBuffer);
+
+    // Uma matriz 4x4 ocupa quatro locations consecutivas, uma por coluna.
+    for (GLuint column = 0; column < 4; ++column)
+    {
+        GLuint location = INSTANCE_MODEL_LOCATION + column;
+        size_t offset = first_instance * sizeof(glm::mat4) + column * sizeof(glm::vec4);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)offset);
+        glVertexAttribDivisor(location, 1);
+        glEnableVertexAttribArray(location);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Instancing_DisableAttributes()
+{
+    for (GLuint column = 0; column < 4; ++column)
+        glDisableVertexAttribArray(INSTANCE_MODEL_LOCATION + column);
+}
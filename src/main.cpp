@@ -15,9 +15,11 @@
 //  vira
 //    #include <cstdio> // Em C++
 //
+#include <climits>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <algorithm>
 
 // Headers abaixo são específicos de C++
@@ -40,6 +42,7 @@
 #include <glm/mat4x4.hpp>
 #include <glm/vec4.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
 
 // Headers da biblioteca para carregar modelos obj
 #include <tiny_obj_loader.h>
@@ -49,6 +52,19 @@
 #include "utils.h"
 #include "matrices.h"
 #include "collisions.h"
+#include "mesh.h"
+#include "assetloader.h"
+#include "geometryarena.h"
+#include "instancing.h"
+#include "culling.h"
+#include "simulation.h"
+#include "headless.h"
+#include "replay.h"
+#include "benchmark.h"
+#include "profiler.h"
+#include "gputimer.h"
+#include "programcache.h"
+#include "filewatcher.h"
 
 
 const float TRACK_MIN_X = -100.0f;
@@ -59,84 +75,40 @@ const float TRACK_MAX_Z =  100.0f;
 glm::vec4 g_SmoothCameraPos = glm::vec4(0.0f); // Posição suavizada da câmera
 float g_CameraSmoothFactor = 4.0f; // Quanto maior, mais rápida a resposta
 
-// Estrutura que representa um modelo geométrico carregado a partir de um
-// arquivo ".obj". Veja https://en.wikipedia.org/wiki/Wavefront_.obj_file .
-struct ObjModel
-{
-    tinyobj::attrib_t                 attrib;
-    std::vector<tinyobj::shape_t>     shapes;
-    std::vector<tinyobj::material_t>  materials;
-
-    // Este construtor lê o modelo de um arquivo utilizando a biblioteca tinyobjloader.
-    // Veja: https://github.com/syoyo/tinyobjloader
-    ObjModel(const char* filename, const char* basepath = NULL, bool triangulate = true)
-    {
-        printf("Carregando objetos do arquivo \"%s\"...\n", filename);
-
-        // Se basepath == NULL, então setamos basepath como o dirname do
-        // filename, para que os arquivos MTL sejam corretamente carregados caso
-        // estejam no mesmo diretório dos arquivos OBJ.
-        std::string fullpath(filename);
-        std::string dirname;
-        if (basepath == NULL)
-        {
-            auto i = fullpath.find_last_of("/");
-            if (i != std::string::npos)
-            {
-                dirname = fullpath.substr(0, i+1);
-                basepath = dirname.c_str();
-            }
-        }
-
-        std::string warn;
-        std::string err;
-        bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filename, basepath, triangulate);
-
-        if (!err.empty())
-            fprintf(stderr, "\n%s\n", err.c_str());
-
-        if (!ret)
-            throw std::runtime_error("Erro ao carregar modelo.");
-
-        for (size_t shape = 0; shape < shapes.size(); ++shape)
-        {
-            if (shapes[shape].name.empty())
-            {
-                fprintf(stderr,
-                        "*********************************************\n"
-                        "Erro: Objeto sem nome dentro do arquivo '%s'.\n"
-                        "Veja https://www.inf.ufrgs.br/~eslgastal/fcg-faq-etc.html#Modelos-3D-no-formato-OBJ .\n"
-                        "*********************************************\n",
-                    filename);
-                throw std::runtime_error("Objeto sem nome.");
-            }
-            printf("- Objeto '%s'\n", shapes[shape].name.c_str());
-        }
-
-        printf("OK.\n");
-    }
-};
-
-
 // Declaração de funções utilizadas para pilha de matrizes de modelagem.
 void PushMatrix(glm::mat4 M);
 void PopMatrix(glm::mat4& M);
 
 // Declaração de várias funções utilizadas em main().  Essas estão definidas
 // logo após a definição de main() neste arquivo.
-void BuildTrianglesAndAddToVirtualScene(ObjModel*); // Constrói representação de um ObjModel como malha de triângulos para renderização
-void ComputeNormals(ObjModel* model); // Computa normais de um ObjModel, caso não existam.
-void LoadShadersFromFiles(); // Carrega os shaders de vértice e fragmento, criando um programa de GPU
-void LoadTextureImage(const char* filename); // Função que carrega imagens de textura
-void ScalePlaneModelAndTexCoords(ObjModel* model); // Escala as coordenadas da malha e da textura do plano
+void BuildTrianglesAndAddToVirtualScene(const MeshData* mesh); // Envia uma malha de triângulos para a GPU e a adiciona na cena virtual
+void LoadShadersFromFiles(); // Carrega os shaders de vértice e fragmento, criando os programas de GPU
+void LoadTextureImage(const LoadedImage& image); // Função que envia imagens de textura para a GPU
 
 void ComputeGravity(glm::vec4& pos, glm::vec4& vel, float delta_t);
 
-void DrawVirtualObject(const char* object_name); // Desenha um objeto armazenado em g_VirtualScene
-GLuint LoadShader_Vertex(const char* filename);   // Carrega um vertex shader
-GLuint LoadShader_Fragment(const char* filename); // Carrega um fragment shader
-void LoadShader(const char* filename, GLuint shader_id); // Função utilizada pelas duas acima
+typedef size_t SceneObjectHandle; // Índice de um objeto em g_SceneObjects
+SceneObjectHandle FindVirtualObject(const char* object_name); // Converte o nome de um objeto da cena em um handle
+void UseGpuProgram(int object_id); // Liga a variante dos shaders de um objeto
+void SetModelMatrix(const glm::mat4& view_projection, const glm::mat4& model); // Envia "model" e as matrizes derivadas dela para a GPU
+void DrawVirtualObject(SceneObjectHandle object); // Desenha um objeto armazenado em g_SceneObjects
+void DrawVirtualObjectInstanced(SceneObjectHandle object, const std::vector<glm::mat4>& instance_models); // Desenha várias cópias de um objeto com uma única chamada
+void DrawVirtualObjectCulled(SceneObjectHandle object, const std::vector<glm::mat4>& instance_models, const InstanceGrid& grid, const Frustum& frustum); // Idem, somente as cópias visíveis
+bool LoadShaderSource(const char* filename, const std::string& defines, std::string* source); // Lê o código de um shader
+GLuint LoadShader_Vertex(const std::string& source);   // Inicia a compilação de um vertex shader
+GLuint LoadShader_Fragment(const std::string& source); // Inicia a compilação de um fragment shader
+void LoadShader(const std::string& source, GLuint shader_id); // Função utilizada pelas duas acima
+bool CheckShaderCompilation(const char* filename, GLuint shader_id); // Imprime os erros de compilação de um shader
+GLuint LinkGpuProgram(GLuint vertex_shader_id, GLuint fragment_shader_id); // Inicia a linkagem de um programa de GPU
+bool CheckGpuProgramLink(GLuint program_id); // Imprime os erros de linkagem de um programa de GPU
 GLuint CreateGpuProgram(GLuint vertex_shader_id, GLuint fragment_shader_id); // Cria um programa de GPU
+void InitParallelShaderCompile(); // Liga a compilação de shaders em threads do driver, se disponível
+void InitFrameUniforms(); // Cria o buffer do bloco "FrameUniforms" dos shaders
+bool StartShaderReload();  // Inicia o recarregamento dos shaders, sem bloquear
+void RequestShaderReload(); // Recarrega os shaders, em segundo plano se o driver permitir
+void UpdateShaderReload(); // Troca os programas de GPU quando o recarregamento termina
+const char* ShaderReloadStatus(); // Mensagem do HUD sobre o recarregamento dos shaders
+void SetShaderReloadStatus(const char* status);
 void PrintObjModelInfo(ObjModel*); // Função para debugging
 
 // Declaração de funções auxiliares para renderizar texto dentro da janela
@@ -145,6 +117,15 @@ void TextRendering_Init();
 float TextRendering_LineHeight(GLFWwindow* window);
 float TextRendering_CharWidth(GLFWwindow* window);
 void TextRendering_PrintString(GLFWwindow* window, const std::string &str, float x, float y, float scale = 1.0f);
+void TextRendering_Flush(); // Desenha todo o texto do quadro com uma única chamada
+
+// Textos retidos: o layout é guardado em um VBO e só é refeito quando o texto
+// ou o tamanho da janela mudam. Veja "textrendering.cpp".
+typedef size_t TextLabel;
+TextLabel TextRendering_CreateLabel(const std::string &str, float x, float y, float scale = 1.0f);
+void TextRendering_SetLabelText(TextLabel label, const std::string &str);
+void TextRendering_BeginFrame(GLFWwindow* window);
+void TextRendering_DrawLabel(TextLabel label);
 void TextRendering_PrintMatrix(GLFWwindow* window, glm::mat4 M, float x, float y, float scale = 1.0f);
 void TextRendering_PrintVector(GLFWwindow* window, glm::vec4 v, float x, float y, float scale = 1.0f);
 void TextRendering_PrintMatrixVectorProduct(GLFWwindow* window, glm::mat4 M, glm::vec4 v, float x, float y, float scale = 1.0f);
@@ -157,6 +138,8 @@ void TextRendering_ShowModelViewProjection(GLFWwindow* window, glm::mat4 project
 void TextRendering_ShowEulerAngles(GLFWwindow* window);
 void TextRendering_ShowProjection(GLFWwindow* window);
 void TextRendering_ShowFramesPerSecond(GLFWwindow* window);
+void TextRendering_ShowCullingStats(GLFWwindow* window);
+void TextRendering_ShowGpuTimes(GLFWwindow* window);
 
 // Funções callback para comunicação com o sistema operacional e interação do
 // usuário. Veja mais comentários nas definições das mesmas, abaixo.
@@ -168,14 +151,15 @@ void CursorPosCallback(GLFWwindow* window, double xpos, double ypos);
 void ScrollCallback(GLFWwindow* window, double xoffset, double yoffset);
 
 // Definimos uma estrutura que armazenará dados necessários para renderizar
-// cada objeto da cena virtual.
+// cada objeto da cena virtual. É utilizada somente durante o carregamento;
+// depois disso os dados ficam em g_SceneObjects.
 struct SceneObject
 {
     std::string  name;        // Nome do objeto
-    size_t       first_index; // Índice do primeiro vértice dentro do vetor indices[] definido em BuildTrianglesAndAddToVirtualScene()
-    size_t       num_indices; // Número de índices do objeto dentro do vetor indices[] definido em BuildTrianglesAndAddToVirtualScene()
+    size_t       first_index; // Índice do primeiro elemento dentro do EBO da arena de geometria (veja "geometryarena.h")
+    size_t       num_indices; // Número de índices do objeto
+    GLint        base_vertex; // Posição do primeiro vértice da malha dentro do VBO da arena
     GLenum       rendering_mode; // Modo de rasterização (GL_TRIANGLES, GL_TRIANGLE_STRIP, etc.)
-    GLuint       vertex_array_object_id; // ID do VAO onde estão armazenados os atributos do modelo
     glm::vec3    bbox_min; // Axis-Aligned Bounding Box do objeto
     glm::vec3    bbox_max;
 };
@@ -183,11 +167,27 @@ struct SceneObject
 
 // Abaixo definimos variáveis globais utilizadas em várias funções do código.
 
-// A cena virtual é uma lista de objetos nomeados, guardados em um dicionário
-// (map).  Veja dentro da função BuildTrianglesAndAddToVirtualScene() como que são incluídos
-// objetos dentro da variável g_VirtualScene, e veja na função main() como
-// estes são acessados.
-std::map<std::string, SceneObject> g_VirtualScene;
+// A cena virtual é uma lista de objetos guardados em vetores contíguos, um
+// por campo de SceneObject ("structure of arrays"). Cada objeto é
+// identificado por um SceneObjectHandle, que é o seu índice nestes vetores.
+// Veja dentro da função BuildTrianglesAndAddToVirtualScene() como que são
+// incluídos objetos na cena, e veja na função main() como estes são acessados.
+struct SceneObjectArray
+{
+    std::vector<std::string> name;
+    std::vector<size_t>      first_index;
+    std::vector<size_t>      num_indices;
+    std::vector<GLint>       base_vertex;
+    std::vector<GLenum>      rendering_mode;
+    std::vector<glm::vec3>   bbox_min;
+    std::vector<glm::vec3>   bbox_max;
+};
+SceneObjectArray g_SceneObjects;
+
+// Dicionário (map) que associa o nome de cada objeto ao seu handle. Só é
+// consultado durante o carregamento (veja FindVirtualObject()); o laço de
+// renderização utiliza diretamente os handles.
+std::map<std::string, SceneObjectHandle> g_VirtualScene;
 
 // Pilha que guardará as matrizes de modelagem.
 std::stack<glm::mat4>  g_MatrixStack;
@@ -221,16 +221,11 @@ float GuardPositionY = 0.0f;
 float GuardPositionZ = 0.0f;
 
 // Escala do plano
-float g_PlaneScale = 50.0f;
+float g_PlaneScale = TRACK_PLANE_SCALE;
 
-// Posição do Carro
-glm::vec4 g_CarPos;
-
-// Posição do Carro 2 player (pc)
-glm::vec4 g_CarPos_pc;
-
-//Velocidade do Carro 2 player (pc)
-float g_CarSpeed_pc = 0.0f;
+// Estado da corrida: posição, velocidade e rotação dos carros, dificuldade
+// e tempo de corrida. Veja "simulation.h".
+SimulationState g_Simulation;
 
 // Variável que controla qual câmera usar: falsa para câmera livre, verdadeira para look-at.
 bool g_CameraLookAt = true;
@@ -250,15 +245,36 @@ bool g_AKeyPressedFree    = false;
 bool g_DKeyPressedFree    = false;
 bool g_BKeyPressedFree    = false;
 
-// Variáveis para simulação de física
-float g_Gravity = -9.8f; // Aceleração da gravidade (em unidades/s^2, ajuste conforme necessário)
-glm::vec3 g_CarVelocity = glm::vec3(0.0f, 0.0f, 0.0f); // Velocidade do carro
-float g_CarYaw = 0.0f; // Rotação do carro em torno do eixo Y (guinada)
-float g_CarYaw_pc = 0.0f; // Rotação do carro em torno do eixo Y (guinada)
-
 // Variável para cálculo do tempo entre frames (deltaTime)
 double g_LastTime = 0.0;
 
+// A simulação avança em passos fixos de SIMULATION_TIMESTEP segundos,
+// independentemente da taxa de quadros. g_SimulationAccumulator guarda o tempo
+// real ainda não simulado. Para a renderização, as posições dos carros são
+// interpoladas entre o estado anterior (g_Prev*) e o atual.
+const float SIMULATION_MAX_FRAME_TIME = 0.25f; // Evita a "espiral da morte" após travamentos
+double g_SimulationAccumulator = 0.0;
+glm::vec4 g_PrevCarPos;
+glm::vec4 g_PrevCarPos_pc;
+float g_PrevCarYaw = 0.0f;
+float g_PrevCarYaw_pc = 0.0f;
+
+// Replay da corrida (veja "replay.h"). Com "--record ARQUIVO" os passos são
+// gravados e salvos ao fechar a janela; com "--replay ARQUIVO" as teclas do
+// carro e a dificuldade vêm do arquivo em vez do teclado.
+Replay      g_Replay;
+const char* g_ReplayRecordFilename = NULL;
+bool        g_ReplayPlayback = false;
+
+// Modo de benchmark (veja "benchmark.h")
+bool        g_BenchmarkMode = false;
+Benchmark   g_Benchmark;
+const char* g_BenchmarkOutputFilename = "benchmark.json";
+
+// Profiling por escopos (veja "profiler.h"). Com "--profile ARQUIVO" a coleta
+// começa junto com o programa; F8 habilita a coleta ou salva o trace.
+const char* g_ProfileOutputFilename = "trace.json";
+
 // Ângulos de Euler que controlam a rotação de um dos cubos da cena virtual
 float g_AngleX = 0.0f;
 float g_AngleY = 0.0f;
@@ -292,27 +308,79 @@ bool g_UsePerspectiveProjection = true;
 // Variável que controla se o texto informativo será mostrado na tela.
 bool g_ShowInfoText = true;
 
+// Número de instâncias desenhadas e descartadas pelo frustum culling no
+// quadro atual. Veja DrawVirtualObjectCulled().
+size_t g_VisibleInstances = 0;
+size_t g_CulledInstances = 0;
+
 // Variáveis de estado das teclas para movimentação do carro
 bool g_WKeyPressed = false;
 bool g_AKeyPressed = false;
 bool g_SKeyPressed = false;
 bool g_DKeyPressed = false;
 
-// Parâmetros de movimento do carro
-float g_CarSpeed = 0.0f; // Velocidade atual do carro
-float g_CarMaxSpeed = 25.0f; // Velocidade máximas
-float g_CarAcceleration = 5.0f; // Aceleração
-float g_CarDeceleration = 5.0f; // Desaceleração (freio)
-float g_CarRotationSpeed = 1.0f; // Velocidade de rotação (guinada)
-
 // Variáveis que definem um programa de GPU (shaders). Veja função LoadShadersFromFiles().
-GLuint g_GpuProgramID = 0;
-GLint g_model_uniform;
-GLint g_view_uniform;
-GLint g_projection_uniform;
-GLint g_object_id_uniform;
-GLint g_bbox_min_uniform;
-GLint g_bbox_max_uniform;
+// Cada objeto (TRACK, CAR, ...) é desenhado com uma variante própria dos
+// shaders, compilada com "#define OBJECT_ID <identificador>".
+#define NUM_GPU_PROGRAMS 10 // Um por identificador de objeto
+struct GpuProgram
+{
+    GLuint id;
+    GLint  model_uniform;
+    GLint  model_view_projection_uniform;
+    GLint  normal_matrix_uniform;
+    GLint  bbox_min_uniform;
+    GLint  bbox_max_uniform;
+};
+GpuProgram g_GpuPrograms[NUM_GPU_PROGRAMS];
+const GpuProgram* g_CurrentGpuProgram = &g_GpuPrograms[0]; // Veja UseGpuProgram()
+
+// Bloco "FrameUniforms" de "shader_fragment.glsl" (layout std140): valores
+// que mudam uma vez por quadro e são iguais para todas as variantes dos
+// shaders. Ficam em um único "uniform buffer", ligado ao ponto
+// FRAME_UNIFORMS_BINDING, em vez de serem enviados para cada programa.
+struct FrameUniforms
+{
+    glm::vec4 camera_position;
+};
+#define FRAME_UNIFORMS_BINDING 0
+GLuint g_FrameUniformBuffer = 0;
+
+// Recarregamento dos shaders em andamento (veja StartShaderReload()). Os
+// programas novos só substituem g_GpuPrograms quando todos estão prontos e
+// sem erros; assim um shader com erro nunca interrompe o jogo.
+struct PendingGpuProgram
+{
+    GLuint      id;
+    GLuint      vertex_shader_id;   // 0 se o programa veio do cache
+    GLuint      fragment_shader_id;
+    std::string vertex_source;
+    std::string fragment_source;
+
+    PendingGpuProgram() : id(0), vertex_shader_id(0), fragment_shader_id(0) {}
+};
+PendingGpuProgram g_PendingGpuPrograms[NUM_GPU_PROGRAMS];
+bool g_ShaderReloadPending = false;
+
+// Recarregamento síncrono pedido por RequestShaderReload(), feito depois que
+// um quadro com o aviso do HUD for desenhado (veja UpdateShaderReload())
+bool g_ShaderReloadRequested = false;
+int  g_ShaderReloadRequestFrames = 0; // Chamadas de UpdateShaderReload() desde o pedido
+
+// Mensagem mostrada no HUD sobre o último recarregamento (ou NULL) e o
+// instante em que foi definida. Veja ShaderReloadStatus().
+const char* g_ShaderReloadStatus     = NULL;
+double      g_ShaderReloadStatusTime = 0.0;
+#define SHADER_RELOAD_STATUS_SECONDS 2.0
+
+// GL_KHR_parallel_shader_compile (ou ARB) disponível. Veja InitParallelShaderCompile().
+bool g_ParallelShaderCompile = false;
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// Observa "../data/shaders/" para recarregar os shaders quando forem salvos
+FileWatcher g_ShaderWatcher = { -1, -1, "" };
 
 // Número de texturas carregadas pela função LoadTextureImage()
 GLuint g_NumLoadedTextures = 0;
@@ -327,15 +395,86 @@ glm::vec3 BezierCubic(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, glm::vec3 p3, fl
     return u*u*u*p0 + 3*u*u*t*p1 + 3*u*t*t*p2 + t*t*t*p3;
 }
 
-double g_GameStartTime = 0.0;
-bool g_RaceStarted = false;
+// Caminho da câmera no modo de benchmark: três curvas Bézier cúbicas
+// encadeadas ao longo da pista, da largada até depois da chegada. O último
+// ponto de cada curva é o primeiro da seguinte.
+const glm::vec3 BENCHMARK_CAMERA_PATH[] = {
+    glm::vec3(  8.0f,  3.0f, -340.0f),
+    glm::vec3( 10.0f,  6.0f, -250.0f), glm::vec3(-10.0f,  8.0f, -150.0f), glm::vec3( -8.0f,  4.0f,  -50.0f),
+    glm::vec3( -6.0f,  2.0f,   50.0f), glm::vec3( 12.0f, 10.0f,  150.0f), glm::vec3(  6.0f,  5.0f,  250.0f),
+    glm::vec3(  0.0f,  3.0f,  320.0f), glm::vec3( -6.0f,  8.0f,  380.0f), glm::vec3(  0.0f, 12.0f,  430.0f),
+};
 
-int g_DifficultyLevel=1;        // 0 = fácil, 1 = médio, 2 = difícil
-bool g_DifficultyChosen = false;  // True se o jogador já escolheu a dificuldade
+// Posição da câmera do benchmark no instante "t" do caminho, entre 0 e 1
+glm::vec3 BenchmarkCameraPosition(float t)
+{
+    const int num_curves = (sizeof(BENCHMARK_CAMERA_PATH) / sizeof(BENCHMARK_CAMERA_PATH[0]) - 1) / 3;
+    float curve_t = glm::clamp(t, 0.0f, 1.0f) * num_curves;
+    int curve = std::min((int)curve_t, num_curves - 1);
+    const glm::vec3* p = &BENCHMARK_CAMERA_PATH[3 * curve];
+    return BezierCubic(p[0], p[1], p[2], p[3], curve_t - curve);
+}
 
 
 int main(int argc, char* argv[])
 {
+    // "--headless" executa somente a simulação da corrida, sem janela e sem
+    // OpenGL. Veja "headless.h".
+    if ( argc > 1 && strcmp(argv[1], "--headless") == 0 )
+        return Headless_Run(argc, argv);
+
+    Profiler_Init();
+
+    // Demais argumentos: gravação/reprodução de replay, ou um modelo extra
+    // a ser carregado na cena.
+    const char* extra_model_filename = NULL;
+    int benchmark_frames = 1800;
+    Replay_Init(&g_Replay);
+    for (int i = 1; i < argc; ++i)
+    {
+        if ( strcmp(argv[i], "--record") == 0 && i + 1 < argc )
+        {
+            g_ReplayRecordFilename = argv[++i];
+        }
+        else if ( strcmp(argv[i], "--benchmark") == 0 )
+        {
+            g_BenchmarkMode = true;
+        }
+        else if ( strcmp(argv[i], "--frames") == 0 && i + 1 < argc )
+        {
+            benchmark_frames = atoi(argv[++i]);
+        }
+        else if ( strcmp(argv[i], "--output") == 0 && i + 1 < argc )
+        {
+            g_BenchmarkOutputFilename = argv[++i];
+        }
+        else if ( strcmp(argv[i], "--profile") == 0 && i + 1 < argc )
+        {
+            g_ProfileOutputFilename = argv[++i];
+            Profiler_SetEnabled(true);
+        }
+        else if ( strcmp(argv[i], "--replay") == 0 && i + 1 < argc )
+        {
+            if ( !Replay_Load(argv[++i], &g_Replay) )
+                std::exit(EXIT_FAILURE);
+            g_ReplayPlayback = true;
+        }
+        else
+        {
+            extra_model_filename = argv[i];
+        }
+    }
+    if ( g_ReplayPlayback && g_ReplayRecordFilename != NULL )
+    {
+        fprintf(stderr, "ERROR: --record and --replay cannot be used together.\n");
+        std::exit(EXIT_FAILURE);
+    }
+    if ( g_BenchmarkMode && benchmark_frames < 1 )
+    {
+        fprintf(stderr, "ERROR: Invalid number of benchmark frames.\n");
+        std::exit(EXIT_FAILURE);
+    }
+
     // Inicializamos a biblioteca GLFW, utilizada para criar uma janela do
     // sistema operacional, onde poderemos renderizar com OpenGL.
     int success = glfwInit();
@@ -388,6 +527,14 @@ int main(int argc, char* argv[])
     // biblioteca GLAD.
     gladLoadGLLoader((GLADloadproc) glfwGetProcAddress);
 
+    // Funções do cache de programas de GPU, que não fazem parte do OpenGL 3.3.
+    // Veja "programcache.h".
+    ProgramCache_Init();
+    InitParallelShaderCompile();
+
+    // Buffer dos valores enviados uma vez por quadro para os shaders
+    InitFrameUniforms();
+
     // Definimos a função de callback que será chamada sempre que a janela for
     // redimensionada, por consequência alterando o tamanho do "framebuffer"
     // (região de memória onde são armazenados os pixels da imagem).
@@ -402,110 +549,186 @@ int main(int argc, char* argv[])
 
     printf("GPU: %s, %s, OpenGL %s, GLSL %s\n", vendor, renderer, glversion, glslversion);
 
-    // Carregamos os shaders de vértices e de fragmentos que serão utilizados
-    // para renderização. Veja slides 180-200 do documento Aula_03_Rendering_Pipeline_Grafico.pdf.
-    //
-    LoadShadersFromFiles();
-
-    // Carregamos duas imagens para serem utilizadas como textura
-    LoadTextureImage("../data/asphalt.jpg");               // TextureImage0
-    LoadTextureImage("../data/tc-car_surface.jpg");        // TextureImage1
-    LoadTextureImage("../data/tc-wall.jpg");               // TextureImage2
-    LoadTextureImage("../data/arcos.jpg");                 // TextureImage3
-    LoadTextureImage("../data/guardRail.jpg");             // TextureImage4
-    LoadTextureImage("../data/ruedas.jpg");                // TextureImage5
-    LoadTextureImage("../data/ventanas.jpg");              // TextureImage6
-    LoadTextureImage("../data/tc-car_surface_pc.jpg");     // TextureImage7
-    LoadTextureImage("../data/Tex_6.jpg");                 // TextureImage8
-    LoadTextureImage("../data/grandma.jpg");               // TextureImage9
-
-    // Construímos a representação de objetos geométricos através de malhas de triângulos
-    ObjModel trackmodel("../data/track.obj");
-    ScalePlaneModelAndTexCoords(&trackmodel);
-    ComputeNormals(&trackmodel);
-    BuildTrianglesAndAddToVirtualScene(&trackmodel);
-
-    ObjModel carmodel("../data/car.obj");
-    ComputeNormals(&carmodel);
-    BuildTrianglesAndAddToVirtualScene(&carmodel);
-
-    ObjModel wallmodel("../data/wall.obj");
-    ComputeNormals(&wallmodel);
-    BuildTrianglesAndAddToVirtualScene(&wallmodel);
-
-    ObjModel arcsmodel("../data/arcos.obj");
-    ComputeNormals(&arcsmodel);
-    BuildTrianglesAndAddToVirtualScene(&arcsmodel);
-
-    ObjModel guardRailmodel("../data/guardRail.obj");
-    ComputeNormals(&guardRailmodel);
-    BuildTrianglesAndAddToVirtualScene(&guardRailmodel);
-
-    ObjModel carpcmodel("../data/car_pc.obj");
-    ComputeNormals(&carpcmodel);
-    BuildTrianglesAndAddToVirtualScene(&carpcmodel);
-
-    ObjModel peoplemodel("../data/people.obj");
-    ComputeNormals(&peoplemodel);
-    BuildTrianglesAndAddToVirtualScene(&peoplemodel);
-
-    ObjModel grandmamodel("../data/grandma.obj");
-    ComputeNormals(&grandmamodel);
-    BuildTrianglesAndAddToVirtualScene(&grandmamodel);
-
-    std::vector<glm::vec3> wall_positions = {
-    {  -6.0f, 0.0f, 405.0f},
-    {  -4.0f, 0.0f, 405.0f},
-    {  -2.0f, 0.0f, 405.0f},
-    {   0.0f, 0.0f, 405.0f},
-    {   2.0f, 0.0f, 405.0f},
-    {   4.0f, 0.0f, 405.0f},
-    {   6.0f, 0.0f, 405.0f}
-};
+    // No benchmark desabilitamos o V-Sync, para medir o tempo real de cada
+    // quadro em vez da taxa de atualização do monitor.
+    if ( g_BenchmarkMode )
+    {
+        glfwSwapInterval(0);
+        Benchmark_Init(&g_Benchmark, benchmark_frames, 30);
+    }
 
-    std::vector<glm::vec3> guardRail_positions;
+    // Iniciamos a leitura dos modelos ".obj" e a decodificação das imagens de
+    // textura em threads de trabalho. Enquanto elas executam, esta thread
+    // compila os shaders; depois enviamos tudo para a GPU de uma só vez.
+    {
+        PROFILE_SCOPE("Carregamento dos recursos");
+
+        AssetLoader loader;
+
+        // Imagens utilizadas como textura, na ordem das unidades de textura
+        loader.AddImage("../data/asphalt.jpg");               // TextureImage0
+        loader.AddImage("../data/tc-car_surface.jpg");        // TextureImage1
+        loader.AddImage("../data/tc-wall.jpg");               // TextureImage2
+        loader.AddImage("../data/arcos.jpg");                 // TextureImage3
+        loader.AddImage("../data/guardRail.jpg");             // TextureImage4
+        loader.AddImage("../data/ruedas.jpg");                // TextureImage5
+        loader.AddImage("../data/ventanas.jpg");              // TextureImage6
+        loader.AddImage("../data/tc-car_surface_pc.jpg");     // TextureImage7
+        loader.AddImage("../data/Tex_6.jpg");                 // TextureImage8
+        loader.AddImage("../data/grandma.jpg");               // TextureImage9
+
+        // Construímos a representação de objetos geométricos através de malhas
+        // de triângulos. LoadMeshData() reutiliza o cache binário
+        // "*.obj.meshcache" gerado na primeira execução.
+        loader.AddMesh("../data/track.obj", g_PlaneScale);
+        loader.AddMesh("../data/car.obj");
+        loader.AddMesh("../data/wall.obj");
+        loader.AddMesh("../data/arcos.obj");
+        loader.AddMesh("../data/guardRail.obj");
+        loader.AddMesh("../data/car_pc.obj");
+        loader.AddMesh("../data/people.obj");
+        loader.AddMesh("../data/grandma.obj");
+
+        if ( extra_model_filename != NULL )
+            loader.AddMesh(extra_model_filename);
+
+        // Carregamos os shaders de vértices e de fragmentos que serão utilizados
+        // para renderização. Veja slides 180-200 do documento Aula_03_Rendering_Pipeline_Grafico.pdf.
+        //
+        LoadShadersFromFiles();
 
-    // Inicializa a sequência de posições ao longo do eixo X e Z
-    float z_increment = 5.0f; // Incremento do eixo Z
-    float x_values[] = {-5.0f, 5.0f}; // Valores de X alternando entre -5.0f e 5.0f
+        // Durante o jogo, os shaders salvos em "../data/shaders/" são
+        // recarregados automaticamente (exceto no benchmark, cujos quadros
+        // devem ser todos iguais).
+        if ( !g_BenchmarkMode )
+            FileWatcher_Init(&g_ShaderWatcher, "../data/shaders/", ".glsl");
 
-    // Gerar posições com alternância de X
-    for (int i = 0; i < 2; ++i) {  // i = 0 -> X = -5.0f, i = 1 -> X = 5.0f
-        float x = x_values[i];  // Definir valor de X para a iteração
+        {
+            PROFILE_SCOPE("AssetLoader::Wait");
+            loader.Wait();
+        }
 
-        // Gerar as posições ao longo do eixo Z 
-        for (float z = -320.0f; z <= 400.0f; z += z_increment) {
-            // Adiciona a posição no vetor guardRail_positions
-            guardRail_positions.push_back(glm::vec3(x, 0.8f, z));
+        for (size_t i = 0; i < loader.images.size(); ++i)
+        {
+            PROFILE_SCOPE_DETAIL("LoadTextureImage", loader.images[i].filename.c_str());
+            LoadTextureImage(loader.images[i]);
         }
-    }
 
-    // Configura posição inicial do Carro. Certifica-se de que a parte inferior do carro está na mesma altura que o plano.
-    //float car_min_y = g_VirtualScene["the_car"].bbox_min.y;
-    float carSize = g_VirtualScene["tc-car_surface.jpg"].bbox_max.y - g_VirtualScene["tc-car_surface.jpg"].bbox_min.y;
-    float carSizepc = g_VirtualScene["tc-car_surface_pc.jpg"].bbox_max.y - g_VirtualScene["tc-car_surface_pc.jpg"].bbox_min.y;
+        // Reservamos a arena de geometria com o tamanho exato de todas as
+        // malhas, evitando realocações durante o envio.
+        size_t total_vertices = 0;
+        size_t total_indices = 0;
+        for (size_t i = 0; i < loader.meshes.size(); ++i)
+        {
+            total_vertices += loader.meshes[i].mesh.vertices.size();
+            total_indices  += loader.meshes[i].mesh.indices.size();
+        }
+        GeometryArena_Init(total_vertices, total_indices);
+        Instancing_Init();
 
-    // TrackPositionY é a coordenada Y do plano. Se o plano estiver em y=0, então TrackPositionY = 0.0f.
-    // A posição Y do carro deve ser TrackPositionY menos a coordenada Y mínima do modelo do carro,
-    // para que a base do carro coincida com a altura do plano.
-    g_CarPos = { 1.0f, 0.0f + carSize, -328.6f, 10.0f };
-    g_CarPos_pc = { -1.0f, 0.0f + carSizepc, -328.6f, 0.0f };
+        for (size_t i = 0; i < loader.meshes.size(); ++i)
+        {
+            if ( !loader.meshes[i].error.empty() )
+                throw std::runtime_error(loader.meshes[i].error);
+            PROFILE_SCOPE_DETAIL("BuildTrianglesAndAddToVirtualScene", loader.meshes[i].filename.c_str());
+            BuildTrianglesAndAddToVirtualScene(&loader.meshes[i].mesh);
+        }
+    }
+
+    std::vector<glm::vec3> wall_positions = Simulation_WallPositions();
+    std::vector<glm::vec3> guardRail_positions = Simulation_GuardRailPositions();
+
+    // Matrizes de modelagem das cópias de cada objeto desenhado com
+    // instanciamento. Como estes objetos não se movem, as matrizes são
+    // calculadas uma única vez. Para adicionar mais guard rails ou
+    // espectadores basta adicionar posições nestes vetores.
+    std::vector<glm::vec3> people_positions = {
+        { PeoplePositionX, PeoplePositionY, PeoplePositionZ }
+    };
+
+    std::vector<glm::mat4> wall_models;
+    for (const auto& pos : wall_positions)
+        wall_models.push_back(Matrix_Translate(pos.x, pos.y, pos.z) * Matrix_Scale(1.0f, 1.0f, 1.0f));
+
+    std::vector<glm::mat4> guardRail_models;
+    for (const auto& pos : guardRail_positions)
+        guardRail_models.push_back(Matrix_Translate(pos.x, pos.y, pos.z) * Matrix_Scale(0.8f, 0.8f, 0.8f)); // Mudar a escala dos cones
+
+    std::vector<glm::mat4> people_models;
+    for (const auto& pos : people_positions)
+        people_models.push_back(Matrix_Translate(pos.x, pos.y, pos.z)
+                              * Matrix_Rotate_Y(0.707 * pos.x)
+                              * Matrix_Scale(2.0f, 2.0f, 2.0f));
+
+    // Grades uniformes sobre as instâncias estáticas, utilizadas para
+    // descartar as cópias fora do campo de visão (frustum culling). Veja "culling.h".
+    InstanceGrid wall_grid, guardRail_grid, people_grid;
+
+    // Dados estáticos da pista utilizados pela simulação, obtidos das
+    // bounding boxes dos objetos da cena. Configura também a posição inicial
+    // dos carros.
+    TrackColliders track;
+    Simulation_BuildTrack(&track,
+        [](const char* name, glm::vec3* bbox_min, glm::vec3* bbox_max) {
+            SceneObjectHandle object = FindVirtualObject(name);
+            *bbox_min = g_SceneObjects.bbox_min[object];
+            *bbox_max = g_SceneObjects.bbox_max[object];
+        },
+        glm::vec3(TrackPositionX, TrackPositionY, TrackPositionZ));
+    Simulation_Init(&g_Simulation, track);
+
+    // O benchmark pula o menu de dificuldade, a não ser que siga um replay
+    if (g_BenchmarkMode && !g_ReplayPlayback)
+        Simulation_ChooseDifficulty(&g_Simulation, 1);
+
+    // Buscamos uma única vez os objetos utilizados no laço de renderização,
+    // evitando buscas por nome a cada quadro.
+    const SceneObjectHandle track_object     = FindVirtualObject("the_track");
+    const SceneObjectHandle car_object       = FindVirtualObject("the_car");
+    const SceneObjectHandle wheels_object    = FindVirtualObject("ruedas");
+    const SceneObjectHandle windows_object   = FindVirtualObject("ventanas");
+    const SceneObjectHandle wall_object      = FindVirtualObject("the_wall");
+    const SceneObjectHandle arcs_object      = FindVirtualObject("the_arcs");
+    const SceneObjectHandle guardRail_object = FindVirtualObject("the_guardRail");
+    const SceneObjectHandle car_pc_object    = FindVirtualObject("the_car_pc");
+    const SceneObjectHandle people_object    = FindVirtualObject("Object_casualMan_28_0");
+    const SceneObjectHandle grandma_object   = FindVirtualObject("Object_TexMap_0");
+
+    InstanceGrid_Build(&wall_grid, wall_models, g_SceneObjects.bbox_min[wall_object], g_SceneObjects.bbox_max[wall_object], 20.0f);
+    InstanceGrid_Build(&guardRail_grid, guardRail_models, g_SceneObjects.bbox_min[guardRail_object], g_SceneObjects.bbox_max[guardRail_object], 20.0f);
+    InstanceGrid_Build(&people_grid, people_models, g_SceneObjects.bbox_min[people_object], g_SceneObjects.bbox_max[people_object], 20.0f);
 
     // Inicializa o tempo para o cálculo do deltaTime
     g_LastTime = glfwGetTime(); // Moved to be properly initialized here before the loop
 
-    g_GameStartTime = g_LastTime; // tempo da inicialização
-
+    g_PrevCarPos = g_Simulation.car_pos;
+    g_PrevCarPos_pc = g_Simulation.car_pos_pc;
+    g_PrevCarYaw = g_Simulation.car_yaw;
+    g_PrevCarYaw_pc = g_Simulation.car_yaw_pc;
 
-    if ( argc > 1 )
-    {
-        ObjModel model(argv[1]);
-        BuildTrianglesAndAddToVirtualScene(&model);
-    }
 
     // Inicializamos o código para renderização de texto.
     TextRendering_Init();
 
+    // Textos do HUD. Os fixos são criados aqui uma única vez; os variáveis
+    // só são reformatados quando o valor mostrado muda.
+    const TextLabel menu_label   = TextRendering_CreateLabel("Escolha a dificuldade para iniciar:", -0.35f, 0.4f, 1.52f);
+    const TextLabel easy_label   = TextRendering_CreateLabel("1 - Easy",    -0.35f, 0.3f, 1.2f);
+    const TextLabel medium_label = TextRendering_CreateLabel("2 - Medium",  -0.35f, 0.2f, 1.2f);
+    const TextLabel hard_label   = TextRendering_CreateLabel("3 - Hard",    -0.35f, 0.1f, 1.2f);
+    const TextLabel won_label    = TextRendering_CreateLabel("YOU WON!",  -0.2f, 0.8f, 2.0f);
+    const TextLabel lost_label   = TextRendering_CreateLabel("YOU LOST!", -0.2f, 0.8f, 2.0f);
+    const TextLabel countdown_label  = TextRendering_CreateLabel("", -0.30f, 0.5f, 2.0f);
+    const TextLabel difficulty_label = TextRendering_CreateLabel("", -0.65f, 0.0f, 1.2f);
+    const TextLabel speed_label      = TextRendering_CreateLabel("", -0.95f, 0.9f, 1.0f);
+    const TextLabel shader_label     = TextRendering_CreateLabel("", -0.95f, -0.9f, 1.0f);
+    int shown_countdown  = INT_MIN;
+    int shown_difficulty = -1;
+    int shown_speed      = INT_MIN; // Velocidade em décimos de km/h
+
+    // Consultas para medir o tempo de GPU de cada passe (veja "gputimer.h")
+    GpuTimer_Init();
+
     // Habilitamos o Z-buffer. Veja slides 104-116 do documento Aula_09_Projecoes.pdf.
     glEnable(GL_DEPTH_TEST);
 
@@ -519,6 +742,12 @@ int main(int argc, char* argv[])
     {
         // Aqui executamos as operações de renderização
 
+        // Cada quadro e cada uma das suas etapas aparecem como escopos no
+        // trace de profiling (veja "profiler.h").
+        PROFILE_SCOPE("Quadro");
+        ProfileScope frame_phase("Simulação");
+        GpuTimer_BeginFrame();
+
         // ===============================================
         // Atualiza deltaTime no início do frame
         // ===============================================
@@ -526,8 +755,65 @@ int main(int argc, char* argv[])
         float deltaTime = (float)(current_time - g_LastTime);
         g_LastTime = current_time;
 
-        //float elapsed = (float)(current_time - g_GameStartTime);
-        float elapsed = g_DifficultyChosen ? (float)(current_time - g_GameStartTime) : 0.0f;
+        // No benchmark o tempo simulado por quadro é fixo, para que todas as
+        // execuções renderizem os mesmos quadros.
+        if (g_BenchmarkMode)
+        {
+            Benchmark_BeginFrame(&g_Benchmark);
+            deltaTime = BENCHMARK_FRAME_TIME;
+        }
+
+        // ===============================================
+        // Simulação com passo fixo
+        // ===============================================
+        // Executamos quantos passos de SIMULATION_TIMESTEP couberem no tempo
+        // real decorrido, de forma que o resultado da corrida não dependa da
+        // taxa de quadros da máquina.
+        g_SimulationAccumulator += std::min(deltaTime, SIMULATION_MAX_FRAME_TIME);
+        while (g_SimulationAccumulator >= SIMULATION_TIMESTEP)
+        {
+            g_PrevCarPos = g_Simulation.car_pos;
+            g_PrevCarPos_pc = g_Simulation.car_pos_pc;
+            g_PrevCarYaw = g_Simulation.car_yaw;
+            g_PrevCarYaw_pc = g_Simulation.car_yaw_pc;
+
+            SimulationInput input = 0;
+            if (g_ReplayPlayback)
+            {
+                input = Replay_InputForStep(g_Replay, &g_Simulation);
+            }
+            else if (g_BenchmarkMode)
+            {
+                input = SIMULATION_KEY_W;
+            }
+            else
+            {
+                if (g_WKeyPressed) input |= SIMULATION_KEY_W;
+                if (g_AKeyPressed) input |= SIMULATION_KEY_A;
+                if (g_SKeyPressed) input |= SIMULATION_KEY_S;
+                if (g_DKeyPressed) input |= SIMULATION_KEY_D;
+            }
+
+            if (g_ReplayRecordFilename != NULL)
+                Replay_RecordStep(&g_Replay, g_Simulation, input);
+
+            Simulation_Step(&g_Simulation, input, track, SIMULATION_TIMESTEP);
+            g_SimulationAccumulator -= SIMULATION_TIMESTEP;
+        }
+
+        // Estado interpolado entre os dois últimos passos, utilizado somente
+        // para a renderização (câmera e carros).
+        float alpha = (float)(g_SimulationAccumulator / SIMULATION_TIMESTEP);
+        glm::vec4 car_pos    = glm::mix(g_PrevCarPos, g_Simulation.car_pos, alpha);
+        glm::vec4 car_pos_pc = glm::mix(g_PrevCarPos_pc, g_Simulation.car_pos_pc, alpha);
+        float car_yaw        = glm::mix(g_PrevCarYaw, g_Simulation.car_yaw, alpha);
+        float car_yaw_pc     = glm::mix(g_PrevCarYaw_pc, g_Simulation.car_yaw_pc, alpha);
+
+        float elapsed = g_Simulation.difficulty_chosen ? (float)g_Simulation.race_time : 0.0f;
+
+        if (g_BenchmarkMode)
+            Benchmark_EndStage(&g_Benchmark, BENCHMARK_STAGE_SIMULATION);
+        frame_phase.Next("Câmera");
 
 
         // Definimos a cor do "fundo" do framebuffer como branco.  Tal cor é
@@ -540,11 +826,9 @@ int main(int argc, char* argv[])
 
         // "Pintamos" todos os pixels do framebuffer com a cor definida acima,
         // e também resetamos todos os pixels do Z-buffer (depth buffer).
+        GpuTimer_Begin(GPU_PASS_CLEAR);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // Pedimos para a GPU utilizar o programa de GPU criado acima (contendo
-        // os shaders de vértice e fragmentos).
-        glUseProgram(g_GpuProgramID);
+        GpuTimer_End();
 
         // Computamos a posição da câmera utilizando coordenadas esféricas.  As
         // variáveis g_CameraDistance, g_CameraPhi, e g_CameraTheta são
@@ -568,10 +852,20 @@ int main(int argc, char* argv[])
 
         glm::mat4 view;
 
-        if (g_SideCameraActive)
+        if (g_BenchmarkMode)
         {
-            glm::vec3 carPos = glm::vec3(g_CarPos);
-            glm::vec3 right = glm::vec3(cos(g_CarYaw), 0.0f, -sin(g_CarYaw));  // lado direito
+            // Câmera do benchmark: percorre o caminho fixo olhando para o
+            // carro do jogador
+            glm::vec4 camera_position_c = glm::vec4(BenchmarkCameraPosition(Benchmark_Progress(g_Benchmark)), 1.0f);
+            glm::vec4 camera_lookat_l = glm::vec4(car_pos.x, car_pos.y + 1.0f, car_pos.z, 1.0f);
+            glm::vec4 camera_view_vector = camera_lookat_l - camera_position_c;
+            glm::vec4 camera_up_vector = glm::vec4(0.0f, 1.0f, 0.0f, 0.0f);
+            view = Matrix_Camera_View(camera_position_c, camera_view_vector, camera_up_vector);
+        }
+        else if (g_SideCameraActive)
+        {
+            glm::vec3 carPos = glm::vec3(car_pos);
+            glm::vec3 right = glm::vec3(cos(car_yaw), 0.0f, -sin(car_yaw));  // lado direito
             glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
 
             g_BezierP0 = carPos + up * 1.5f;  // Posição inicial da câmera (acima do carro)
@@ -599,25 +893,25 @@ int main(int argc, char* argv[])
 
             if (g_CameraLookAt)
             {
-                glm::vec3 car_direction = glm::vec3(sin(g_CarYaw), 0.0f, cos(g_CarYaw));
+                glm::vec3 car_direction = glm::vec3(sin(car_yaw), 0.0f, cos(car_yaw));
                 glm::vec3 camera_offset = -3.5f * car_direction + glm::vec3(0.0f, 1.0f, 0.0f);
-                glm::vec4 camera_position_c = glm::vec4(glm::vec3(g_CarPos) + camera_offset, 1.0f);
-                glm::vec4 camera_lookat_l = glm::vec4(g_CarPos.x, g_CarPos.y + 1.0f, g_CarPos.z, 1.0f);
+                glm::vec4 camera_position_c = glm::vec4(glm::vec3(car_pos) + camera_offset, 1.0f);
+                glm::vec4 camera_lookat_l = glm::vec4(car_pos.x, car_pos.y + 1.0f, car_pos.z, 1.0f);
                 glm::vec4 camera_view_vector = camera_lookat_l - camera_position_c;
                 glm::vec4 camera_up_vector = glm::vec4(0.0f, 1.0f, 0.0f, 0.0f);
                 view = Matrix_Camera_View(camera_position_c, camera_view_vector, camera_up_vector);
             }
             else
             {
-                // glm::vec3 car_direction = glm::vec3(sin(g_CarYaw), 0.0f, cos(g_CarYaw));
+                // glm::vec3 car_direction = glm::vec3(sin(car_yaw), 0.0f, cos(car_yaw));
                 // glm::vec3 eye_offset = glm::vec3(0.0f, 1.5f, 0.0f);
-                // glm::vec3 camera_position = glm::vec3(g_CarPos) + eye_offset;
+                // glm::vec3 camera_position = glm::vec3(car_pos) + eye_offset;
                 // glm::vec3 camera_target = camera_position + car_direction;
 
                 // -------------------------------------------------------------------------
-                glm::vec3 car_direction = glm::vec3(sin(g_CarYaw), 0.0f, cos(g_CarYaw));
+                glm::vec3 car_direction = glm::vec3(sin(car_yaw), 0.0f, cos(car_yaw));
                 glm::vec3 eye_offset = glm::vec3(0.0f, 1.5f, 0.0f); // altura acima do capô
-                glm::vec3 camera_position = glm::vec3(g_CarPos) + eye_offset;
+                glm::vec3 camera_position = glm::vec3(car_pos) + eye_offset;
 
                 // Direção levemente inclinada para trás
                 glm::vec3 reverse_direction = -car_direction;
@@ -665,11 +959,42 @@ int main(int argc, char* argv[])
 
         glm::mat4 model = Matrix_Identity(); // Transformação identidade de modelagem
 
-        // Enviamos as matrizes "view" e "projection" para a placa de vídeo
-        // (GPU). Veja o arquivo "shader_vertex.glsl", onde estas são
-        // efetivamente aplicadas em todos os pontos.
-        glUniformMatrix4fv(g_view_uniform       , 1 , GL_FALSE , glm::value_ptr(view));
-        glUniformMatrix4fv(g_projection_uniform , 1 , GL_FALSE , glm::value_ptr(projection));
+        frame_phase.Next("Desenho da cena");
+
+        // Shaders salvos desde o último quadro são recarregados; com a
+        // compilação paralela do driver, sem bloquear este quadro (veja
+        // RequestShaderReload() e UpdateShaderReload()).
+        if ( FileWatcher_Poll(&g_ShaderWatcher) )
+            RequestShaderReload();
+        UpdateShaderReload();
+
+        // As matrizes "view" e "projection" são compostas uma única vez por
+        // quadro; cada desenho envia para a placa de vídeo (GPU) somente o
+        // produto com a sua matriz "model". Veja SetModelMatrix() e o arquivo
+        // "shader_vertex.glsl".
+        glm::mat4 view_projection = projection * view;
+
+        // Posição da câmera no sistema de coordenadas global, utilizada pela
+        // iluminação em "shader_fragment.glsl": a origem do sistema de
+        // coordenadas da câmera levada de volta pela inversa de "view".
+        // Enviada uma única vez para o buffer do bloco "FrameUniforms", que é
+        // lido por todas as variantes dos shaders.
+        FrameUniforms frame_uniforms;
+        frame_uniforms.camera_position = glm::inverse(view) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        glBindBuffer(GL_UNIFORM_BUFFER, g_FrameUniformBuffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(frame_uniforms), &frame_uniforms);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        // Todos os objetos da cena estão na mesma arena de geometria, então
+        // "ligamos" o seu VAO uma única vez por quadro. Veja DrawVirtualObject().
+        GeometryArena_Bind();
+        Instancing_BeginFrame();
+
+        // Planos do campo de visão da câmera atual, utilizados para descartar
+        // as instâncias que não aparecem na tela.
+        Frustum frustum = ExtractFrustumPlanes(view_projection);
+        g_VisibleInstances = 0;
+        g_CulledInstances = 0;
 
         #define TRACK   0
         #define CAR     1
@@ -686,345 +1011,81 @@ int main(int argc, char* argv[])
         //model = Matrix_Translate(0.0f,-1.1f,0.0f);
         model = Matrix_Translate(TrackPositionX, TrackPositionY, TrackPositionZ);
         model = model * Matrix_Scale(1.0f, 1.0f, 1.0f); // Aumenta a pista lateral e longitudinalmente
-        glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE ,  glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, TRACK);
-        DrawVirtualObject("the_track");
-
-        for (const auto& pos : wall_positions)
-        {
-            model = Matrix_Translate(pos.x, pos.y, pos.z);
-            model = model * Matrix_Scale(1.0f, 1.0f, 1.0f);
-            glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-            glUniform1i(g_object_id_uniform, WALL);
-            DrawVirtualObject("the_wall");
-
-        }
+        UseGpuProgram(TRACK);
+        SetModelMatrix(view_projection, model);
+        GpuTimer_Begin(GPU_PASS_TRACK);
+        DrawVirtualObject(track_object);
+        GpuTimer_End();
+
+        // Paredes, guard rails e pessoas são desenhados com instanciamento:
+        // as matrizes de cada cópia estão em wall_models, guardRail_models e
+        // people_models, e a matriz "model" fica sendo a identidade.
+        model = Matrix_Identity();
+        UseGpuProgram(WALL);
+        SetModelMatrix(view_projection, model);
+        GpuTimer_Begin(GPU_PASS_WALLS);
+        DrawVirtualObjectCulled(wall_object, wall_models, wall_grid, frustum);
+        GpuTimer_End();
 
         model = Matrix_Translate(ArcsPositionX, ArcsPositionY, ArcsPositionZ);
         model = model * Matrix_Scale(1.0f, 1.0f, 1.0f);
-            glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-            glUniform1i(g_object_id_uniform, ARCS);
-            DrawVirtualObject("the_arcs");
-
-        for (const auto& pos : guardRail_positions)
-        {
-            model = Matrix_Translate(pos.x, pos.y, pos.z);
-            model = model * Matrix_Scale(0.8f, 0.8f, 0.8f); // Mudar a escala dos cones
-            glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-            glUniform1i(g_object_id_uniform, GUARD);
-            DrawVirtualObject("the_guardRail");
-
-        }
-
-        model = Matrix_Translate(PeoplePositionX, PeoplePositionY, PeoplePositionZ);
-        model = model * Matrix_Rotate_Y(0.707 * PeoplePositionX);
-        model = model * Matrix_Scale(2.0f, 2.0f, 2.0f);
-        glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, PEOPLE);
-        DrawVirtualObject("Object_casualMan_28_0");
+            UseGpuProgram(ARCS);
+            SetModelMatrix(view_projection, model);
+            GpuTimer_Begin(GPU_PASS_ARCS);
+            DrawVirtualObject(arcs_object);
+            GpuTimer_End();
+
+        model = Matrix_Identity();
+        UseGpuProgram(GUARD);
+        SetModelMatrix(view_projection, model);
+        GpuTimer_Begin(GPU_PASS_GUARDRAILS);
+        DrawVirtualObjectCulled(guardRail_object, guardRail_models, guardRail_grid, frustum);
+        GpuTimer_End();
+
+        UseGpuProgram(PEOPLE);
+        SetModelMatrix(view_projection, model);
+        GpuTimer_Begin(GPU_PASS_PEOPLE);
+        DrawVirtualObjectCulled(people_object, people_models, people_grid, frustum);
+        GpuTimer_End();
 
         model = Matrix_Translate(GrandmaPositionX, GrandmaPositionY, GrandmaPositionZ);
         model = model * Matrix_Rotate_Y(-1.4 * GrandmaPositionX);
         model = model * Matrix_Scale(1.0f, 1.0f, 1.0f);
-        glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, GRANDMA);
-        DrawVirtualObject("Object_TexMap_0");
+        UseGpuProgram(GRANDMA);
+        SetModelMatrix(view_projection, model);
+        GpuTimer_Begin(GPU_PASS_GRANDMA);
+        DrawVirtualObject(grandma_object);
+        GpuTimer_End();
 
 
     //  ===============================================
     //  Lógica de Física (Implementação da Gravidade)
     //  ===============================================
 
-        // Calcula o tempo decorrido desde o último frame
-        //double current_time = glfwGetTime();
-        //float deltaTime = (float)(current_time - g_LastTime);
-        g_LastTime = current_time;
-
-        // Aplica gravidade na velocidade vertical
-        g_CarVelocity.y += g_Gravity * deltaTime;
-
-        // Atualiza a posição do carro com base na velocidade
-        g_CarPos.y += g_CarVelocity.y * deltaTime;
-
-
-    //  ====================================================================================================
-    //  Teste de Colisão (Ponto para AABB)
-    //
-        float plane_size = g_VirtualScene["the_track"].bbox_max.x - g_VirtualScene["the_track"].bbox_min.x;
-        CheckCarbyBounds(g_CarPos, plane_size);
-     //  ====================================================================================================
-
-       // Obtém a altura mínima do modelo dos carros para detecção de colisão com o plano
-       // float car_min_y = g_VirtualScene["the_car"].bbox_min.y;
-       // float car_pc_min_y = g_VirtualScene["the_car_pc"].bbox_min.y;
-        // Calcula a altura da base do carro em relação ao seu ponto de origem
-      //  float car_base_offset = car_min_y;
-
-        // Calcula a altura da base do carro do player 2 (pc) em relação ao seu ponto de origem
-       // float car_pc_base_offset = car_pc_min_y;
-
-        // Posição Y do chão/plano
-      //  float plane_y_position = TrackPositionY;
-
-        // Detecção de colisão com o plano
-        // Se a base do carro (g_CarPos.y + car_base_offset) estiver abaixo do plano,
-        // ajusta a posição para que fique em cima do plano e zera a velocidade vertical.
-       // if (g_CarPos.y + car_base_offset < plane_y_position)
-       // {
-
-       // g_CarPos.y = plane_y_position - car_base_offset;  // Subtrai o offset aqui
-       // g_CarVelocity.y = 0.0f; // Para o carro ao atingir o chão
-       // }
-
-        // Garante que o carro esteja sempre no plano ou acima dele, eliminando o "flutuar"
-      //  g_CarPos.y = glm::max(g_CarPos.y, plane_y_position - car_base_offset);
-
-        // Garante que o carro 2 esteja sempre no plano ou acima dele, eliminando o "flutuar"
-      //  g_CarPos_pc.y = glm::max(g_CarPos.y, plane_y_position - car_pc_base_offset);
-// ===============================================
-// Colisão com o plano
-// ===============================================
-// Obtem informações da cena
-glm::vec3 bbox_min_car = g_VirtualScene["the_car"].bbox_min;
-glm::vec3 bbox_max_car = g_VirtualScene["the_car"].bbox_max;
-
-glm::vec3 bbox_min_car_pc = g_VirtualScene["the_car_pc"].bbox_min;
-glm::vec3 bbox_max_car_pc = g_VirtualScene["the_car_pc"].bbox_max;
-
-glm::vec3 plane_bbox_min = g_VirtualScene["the_track"].bbox_min;
-glm::vec3 plane_bbox_max = g_VirtualScene["the_track"].bbox_max;
-glm::vec3 plane_position = glm::vec3(TrackPositionX, TrackPositionY, TrackPositionZ);
-glm::vec3 plane_scale = glm::vec3(1.0f);
-glm::vec3 plane_min = plane_position + plane_bbox_min * plane_scale;
-glm::vec3 plane_max = plane_position + plane_bbox_max * plane_scale;
-
-   ResolveCarGroundCollision(g_CarPos, bbox_min_car, plane_position.y);
-   ResolveCarGroundCollision(g_CarPos_pc, bbox_min_car_pc, plane_position.y);
-// ===============================================
-
-    // ===============================================
-    // Lógica de Movimento do Carro
-    // ===============================================
-
-        if (elapsed >= 5.0f)
-        {
-            g_RaceStarted = true;
-
-        float current_acceleration = g_CarAcceleration;
-
-        // Aceleração/Desaceleração
-        if (g_WKeyPressed) {
-            g_CarSpeed += current_acceleration * deltaTime;
-        } else if (g_SKeyPressed) {
-            g_CarSpeed -= g_CarDeceleration * deltaTime;
-        } else {
-            // Aplica atrito/desaceleração natural quando nenhuma tecla de movimento está pressionada
-            if (g_CarSpeed > 0) {
-                g_CarSpeed -= g_CarDeceleration * deltaTime;
-                if (g_CarSpeed < 0) g_CarSpeed = 0;
-            } else if (g_CarSpeed < 0) {
-                g_CarSpeed += g_CarDeceleration * deltaTime;
-                if (g_CarSpeed > 0) g_CarSpeed = 0;
-            }
-        }
-
-        // Limita a velocidade máxima
-        g_CarSpeed = glm::clamp(g_CarSpeed, -g_CarMaxSpeed, g_CarMaxSpeed);
-
-        // Rotação (guinada)
-        if (g_AKeyPressed && g_CarSpeed != 0.0f) { // Só vira se estiver em movimento
-            g_CarYaw += g_CarRotationSpeed * deltaTime * (g_CarSpeed > 0 ? 1.0f : -1.0f); // Inverte a rotação se estiver dando ré
-        }
-        if (g_DKeyPressed && g_CarSpeed != 0.0f) { // Só vira se estiver em movimento
-            g_CarYaw -= g_CarRotationSpeed * deltaTime * (g_CarSpeed > 0 ? 1.0f : -1.0f); // Inverte a rotação se estiver dando ré
-        }
-
-        // Atualiza a posição do carro com base na velocidade e direção
-        glm::vec3 direction_vector = glm::vec3(sin(g_CarYaw), 0.0f, cos(g_CarYaw));
-        g_CarPos.x += direction_vector.x * g_CarSpeed * deltaTime;
-        g_CarPos.z += direction_vector.z * g_CarSpeed * deltaTime;
-
-
-    // ===============================================
-    // Fim da Lógica de Movimento do Carro
-    // ===============================================
-
-    // ==================================================================
-    // Lógica bem simples do Movimento do Carro do player 2 - IA (car_pc)
-    // ==================================================================
-
-    //static float g_CarSpeed_pc = 0.0f;
-    float g_CarMaxSpeed_pc; // velocidade máxima da IA
-    float g_CarAcceleration_pc; // aceleração IA
-
-    switch (g_DifficultyLevel)
-    {
-        case 0: // Fácil
-            g_CarMaxSpeed_pc = 15.0f;
-            g_CarAcceleration_pc = 3.0f;
-            break;
-        case 1: // Médio
-            g_CarMaxSpeed_pc = 25.0f;
-            g_CarAcceleration_pc = 4.5f;
-            break;
-        case 2: // Difícil
-            g_CarMaxSpeed_pc = 50.0f;
-            g_CarAcceleration_pc = 9.5f;
-            break;
-        default: // Medio
-            g_CarMaxSpeed_pc = 25.0f;
-            g_CarAcceleration_pc = 4.0f;
-            break;
-    }
-
-    if (g_CarPos_pc.z < 400.0f)
-    {
-        // Aumenta a velocidade até o máximo
-        g_CarSpeed_pc += g_CarAcceleration_pc * deltaTime;
-        g_CarSpeed_pc = glm::min(g_CarSpeed_pc, g_CarMaxSpeed_pc);
-
-        // Atualiza posição da IA (sempre para frente, sem rotação)
-        glm::vec3 dir_pc = glm::vec3(sin(g_CarYaw_pc), 0.0f, cos(g_CarYaw_pc));
-        g_CarPos_pc.x += dir_pc.x * g_CarSpeed_pc * deltaTime;
-        g_CarPos_pc.z += dir_pc.z * g_CarSpeed_pc * deltaTime;
-    }
-    else
-    {
-        // Parou ao final da pista
-        g_CarSpeed_pc = 0.0f;
-    }
-}
-
-// ===============================================
-// Colisão Esfera vs Esfera entre os dois carros
-// ===============================================
-
-// Centro das esferas = posição dos carros
-glm::vec3 center_player = glm::vec3(g_CarPos);
-glm::vec3 center_pc     = glm::vec3(g_CarPos_pc);
-
-// Raio estimado dos carros
-float radius_player = 1.0f;
-float radius_pc     = 1.0f;
-
-//float radius_player = glm::length(g_VirtualScene["the_car"].bbox_max - g_VirtualScene["the_car"].bbox_min) / 2.5f;
-//float radius_pc     = glm::length(g_VirtualScene["the_car_pc"].bbox_max - g_VirtualScene["the_car_pc"].bbox_min) / 2.5f;
-
-//if (CheckSphereCollision(center_player, radius_player, center_pc, radius_pc)) {
-    //std::cout << "Colisão entre carros detectada (esfera vs esfera)!" << std::endl;
-
-    // Resposta simples: anula as velocidades
-   // g_CarSpeed = 0.0f;
-   // g_CarSpeed_pc = 0.0f;
-
-    // Separa os carros suavemente para não ficarem sobrepostos
-   // glm::vec3 direction = glm::normalize(center_player - center_pc);
-   // float overlap = (radius_player + radius_pc) - glm::distance(center_player, center_pc);
-
-    // Aplica deslocamento de recuo proporcional
-   // g_CarPos     += glm::vec4(direction * (overlap * 0.5f), 0.0f);
-   // g_CarPos_pc  -= glm::vec4(direction * (overlap * 0.5f), 0.0f);
-//}
-
-if (ResolveSphereCollision(g_CarPos, radius_player, g_CarSpeed,
-                           g_CarPos_pc, radius_pc, g_CarSpeed_pc)) {
-    //std::cout << "Colisão entre carros detectada (esfera vs esfera)!" << std::endl;
-}
-
-// ===============================================
-// FIM da Colisão Esfera vs Esfera entre os dois carros
-// ===============================================
-// ===============================================
-// Colisão com paredes visíveis
-// ===============================================
-// Obtem informações da cena
-//glm::vec3 bbox_min_car = g_VirtualScene["the_car"].bbox_min;
-//glm::vec3 bbox_max_car = g_VirtualScene["the_car"].bbox_max;
-
-glm::vec3 direction = glm::vec3(sin(g_CarYaw), 0.0f, cos(g_CarYaw));
-glm::vec3 move = direction * g_CarSpeed * deltaTime;
-glm::vec4 tentativeCarPos = g_CarPos + glm::vec4(move, 0.0f);
-BoundingBox tentativeBox = ComputeCarAABB(tentativeCarPos, bbox_min_car, bbox_max_car);
-
-bool hitWall = false;
-
-if (!hitWall) {
-    hitWall = ResolveCarWallCollision(
-        tentativeCarPos,
-        g_CarPos,
-        bbox_min_car,
-        bbox_max_car,
-        g_CarSpeed,
-        wall_positions,
-        g_VirtualScene["the_wall"].bbox_min,
-        g_VirtualScene["the_wall"].bbox_max,
-        glm::vec3(0.01f)
-    );
-}
-// ===============================================
-// Colisão com os guard rails (cubo vs cubo)
-// ===============================================
-if (!hitWall) {
-    hitWall = ResolveCarWallCollision(
-        tentativeCarPos,
-        g_CarPos,
-        bbox_min_car,
-        bbox_max_car,
-        g_CarSpeed,
-        guardRail_positions,
-        g_VirtualScene["the_guardRail"].bbox_min,
-        g_VirtualScene["the_guardRail"].bbox_max,
-        glm::vec3(0.8f) // Escala aplicada na renderização
-    );
-}
-// ===============================================
-// Aplicação do movimento e tratamento de colisão
-// ===============================================
-if (!hitWall) {
-    g_CarPos = tentativeCarPos; // Movimento aceito
-} else {
-    g_CarPos = tentativeCarPos; // Aplicar posição corrigida com empurrão
-    g_CarSpeed = 0.0f;
-}
-// ===============================================
-// Saída do Plano/Paredes invisíveis
-// ===============================================
-//BoundingBox finalBox = ComputeCarAABB(g_CarPos, bbox_min_car, bbox_max_car);
-
-//bool insidePlane =
-//    finalBox.min.x >= plane_min.x && finalBox.max.x <= plane_max.x &&
-//    finalBox.min.z >= plane_min.z && finalBox.max.z <= plane_max.z;
-
-//if (insidePlane) {
-//    ResolveCarGroundCollision(g_CarPos, bbox_min_car, plane_position.y);
-//} else {
-//    std::cout << "Carro saiu do plano. Vai cair!" << std::endl;
-//}
-// ===============================================
-// FIM DA LÓGICA DE COLISÃO
-// ===============================================
 
         // Desenhamos o modelo do carro usando a posição e rotação atualizadas
-        model = Matrix_Translate(g_CarPos.x, g_CarPos.y + 0.075f, g_CarPos.z);
+        GpuTimer_Begin(GPU_PASS_CARS);
+        model = Matrix_Translate(car_pos.x, car_pos.y + 0.075f, car_pos.z);
         //model = model * Matrix_Scale(0.5f, 0.5f, 0.5f); // reduz o carro pela metade
-        model = model * Matrix_Rotate_Y(g_CarYaw); // Aplica a rotação do carro
-        glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, CAR);
-        DrawVirtualObject("the_car");       
-        glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, WHEEL);
-        DrawVirtualObject("ruedas");
-        glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, WINDOW);
-        DrawVirtualObject("ventanas");
+        model = model * Matrix_Rotate_Y(car_yaw); // Aplica a rotação do carro
+        UseGpuProgram(CAR);
+        SetModelMatrix(view_projection, model);
+        DrawVirtualObject(car_object);       
+        UseGpuProgram(WHEEL);
+        SetModelMatrix(view_projection, model);
+        DrawVirtualObject(wheels_object);
+        UseGpuProgram(WINDOW);
+        SetModelMatrix(view_projection, model);
+        DrawVirtualObject(windows_object);
 
         // Desenhamos o modelo do carro usando a posição e rotação atualizadas
-        model = Matrix_Translate(g_CarPos_pc.x, g_CarPos_pc.y, g_CarPos_pc.z);
+        model = Matrix_Translate(car_pos_pc.x, car_pos_pc.y, car_pos_pc.z);
         //model = model * Matrix_Scale(0.5f, 0.5f, 0.5f); // reduz o carro pela metade
-        model = model * Matrix_Rotate_Y(g_CarYaw_pc); // Aplica a rotação do carro
-        glUniformMatrix4fv(g_model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(g_object_id_uniform, PC);
-        DrawVirtualObject("the_car_pc");
+        model = model * Matrix_Rotate_Y(car_yaw_pc); // Aplica a rotação do carro
+        UseGpuProgram(PC);
+        SetModelMatrix(view_projection, model);
+        DrawVirtualObject(car_pc_object);
+        GpuTimer_End();
 
         //g_CarPos.x = std::max(TRACK_MIN_X, std::min(g_CarPos.x, TRACK_MAX_X));
         //g_CarPos.z = std::max(TRACK_MIN_Z, std::min(g_CarPos.z, TRACK_MAX_Z));
@@ -1033,48 +1094,90 @@ if (!hitWall) {
         // Fim da Lógica de Física
         // ===============================================
 
+        if (g_BenchmarkMode)
+            Benchmark_EndStage(&g_Benchmark, BENCHMARK_STAGE_SCENE);
+        frame_phase.Next("HUD");
+        GpuTimer_Begin(GPU_PASS_TEXT);
+
         // Imprimimos na tela informação sobre o número de quadros renderizados
         // por segundo (frames per second).
         TextRendering_ShowFramesPerSecond(window);
+        TextRendering_ShowCullingStats(window);
+        TextRendering_ShowGpuTimes(window);
+
+        TextRendering_BeginFrame(window);
 
-        if (!g_RaceStarted)
+        if (!g_Simulation.race_started)
         {
-            if (!g_DifficultyChosen)
+            if (!g_Simulation.difficulty_chosen)
             {
-                TextRendering_PrintString(window, "Escolha a dificuldade para iniciar:", -0.35f, 0.4f, 1.52f);
-                TextRendering_PrintString(window, "1 - Easy",    -0.35f, 0.3f, 1.2f);
-                TextRendering_PrintString(window, "2 - Medium",  -0.35f, 0.2f, 1.2f);
-                TextRendering_PrintString(window, "3 - Hard",    -0.35f, 0.1f, 1.2f);
+                TextRendering_DrawLabel(menu_label);
+                TextRendering_DrawLabel(easy_label);
+                TextRendering_DrawLabel(medium_label);
+                TextRendering_DrawLabel(hard_label);
             }
             else
             {
                 int countdown = 5 - (int)elapsed;
-                char countdown_text[32];
-                snprintf(countdown_text, sizeof(countdown_text), "Arrancada em: %d", countdown);
-                TextRendering_PrintString(window, countdown_text, -0.30f, 0.5f, 2.0f);
-
-                const char* dificuldade_textos[] = {"Easy", "Medium", "Hard"};
-                char difftxt[64];
-                snprintf(difftxt, sizeof(difftxt), "Dificuldade: %s", dificuldade_textos[g_DifficultyLevel]);
-                TextRendering_PrintString(window, difftxt, -0.65f, 0.0f, 1.2f);
+                if (countdown != shown_countdown)
+                {
+                    char countdown_text[32];
+                    snprintf(countdown_text, sizeof(countdown_text), "Arrancada em: %d", countdown);
+                    TextRendering_SetLabelText(countdown_label, countdown_text);
+                    shown_countdown = countdown;
+                }
+                TextRendering_DrawLabel(countdown_label);
+
+                if (g_Simulation.difficulty_level != shown_difficulty)
+                {
+                    const char* dificuldade_textos[] = {"Easy", "Medium", "Hard"};
+                    char difftxt[64];
+                    snprintf(difftxt, sizeof(difftxt), "Dificuldade: %s", dificuldade_textos[g_Simulation.difficulty_level]);
+                    TextRendering_SetLabelText(difficulty_label, difftxt);
+                    shown_difficulty = g_Simulation.difficulty_level;
+                }
+                TextRendering_DrawLabel(difficulty_label);
             }
         }
 
         // Mostra a velocidade em tempo real
-        float speed_kmh = g_CarSpeed * 3.6f *3.f;
-        char velocimetro_texto[64];
-        snprintf(velocimetro_texto, sizeof(velocimetro_texto), "Velocidade: %.1f km/h", speed_kmh);
-        TextRendering_PrintString(window, velocimetro_texto, -0.95f, 0.9f, 1.0f);
+        float speed_kmh = g_Simulation.car_speed * 3.6f *3.f;
+        int speed_tenths = (int)std::lround(speed_kmh * 10.0f);
+        if (speed_tenths != shown_speed)
+        {
+            char velocimetro_texto[64];
+            snprintf(velocimetro_texto, sizeof(velocimetro_texto), "Velocidade: %.1f km/h", speed_tenths / 10.0f);
+            TextRendering_SetLabelText(speed_label, velocimetro_texto);
+            shown_speed = speed_tenths;
+        }
+        TextRendering_DrawLabel(speed_label);
+
+        // Andamento do recarregamento dos shaders (tecla R ou arquivo salvo)
+        const char* shader_status = ShaderReloadStatus();
+        if (shader_status != NULL)
+        {
+            TextRendering_SetLabelText(shader_label, shader_status);
+            TextRendering_DrawLabel(shader_label);
+        }
 
-        if (g_CarPos.z >= 400.0f)
+        int winner = Simulation_Winner(g_Simulation);
+        if (winner == RACE_WINNER_PLAYER)
         {
-            TextRendering_PrintString(window, "YOU WON!", -0.2f, 0.8f, 2.0f);
+            TextRendering_DrawLabel(won_label);
         }
-        else if (g_CarPos_pc.z >= 400.0f)
+        else if (winner == RACE_WINNER_PC)
         {
-            TextRendering_PrintString(window, "YOU LOST!", -0.2f, 0.8f, 2.0f);
+            TextRendering_DrawLabel(lost_label);
         }
 
+        // Todo o texto do quadro é desenhado de uma só vez
+        TextRendering_Flush();
+        GpuTimer_End();
+
+        if (g_BenchmarkMode)
+            Benchmark_EndStage(&g_Benchmark, BENCHMARK_STAGE_HUD);
+        frame_phase.Next("Apresentação");
+
         // O framebuffer onde OpenGL executa as operações de renderização não
         // é o mesmo que está sendo mostrado para o usuário, caso contrário
         // seria possível ver artefatos conhecidos como "screen tearing". A
@@ -1089,33 +1192,56 @@ if (!hitWall) {
         // definidas anteriormente usando glfwSet*Callback() serão chamadas
         // pela biblioteca GLFW.
         glfwPollEvents();
+
+        if (g_BenchmarkMode)
+        {
+            Benchmark_EndStage(&g_Benchmark, BENCHMARK_STAGE_PRESENT);
+            Benchmark_EndFrame(&g_Benchmark);
+            if (Benchmark_Finished(g_Benchmark))
+                glfwSetWindowShouldClose(window, GL_TRUE);
+        }
+    }
+
+    if (g_BenchmarkMode && Benchmark_Finished(g_Benchmark))
+    {
+        int width, height;
+        glfwGetFramebufferSize(window, &width, &height);
+        Benchmark_WriteJSON(g_Benchmark, g_BenchmarkOutputFilename, (const char*)renderer, width, height);
     }
 
+    if (g_ReplayRecordFilename != NULL)
+    {
+        g_Replay.final_checksum = Replay_Checksum(g_Simulation);
+        Replay_Save(g_ReplayRecordFilename, g_Replay);
+    }
+
+    if (g_ProfilerEnabled)
+        Profiler_WriteChromeTrace(g_ProfileOutputFilename);
+
     // Finalizamos o uso dos recursos do sistema operacional
+    FileWatcher_Destroy(&g_ShaderWatcher);
     glfwTerminate();
 
     // Fim do programa
     return 0;
 }
 
-// Função que carrega uma imagem para ser utilizada como textura
-void LoadTextureImage(const char* filename)
+// Função que envia para a GPU uma imagem, já decodificada por AssetLoader,
+// para ser utilizada como textura
+void LoadTextureImage(const LoadedImage& image)
 {
-    printf("Carregando imagem \"%s\"... ", filename);
+    printf("Carregando imagem \"%s\"... ", image.filename.c_str());
 
-    // Primeiro fazemos a leitura da imagem do disco
-    stbi_set_flip_vertically_on_load(true);
-    int width;
-    int height;
-    int channels;
-    unsigned char *data = stbi_load(filename, &width, &height, &channels, 3);
-
-    if ( data == NULL )
+    if ( image.data == NULL )
     {
-        fprintf(stderr, "ERROR: Cannot open image file \"%s\".\n", filename);
+        fprintf(stderr, "ERROR: Cannot open image file \"%s\".\n", image.filename.c_str());
         std::exit(EXIT_FAILURE);
     }
 
+    int width = image.width;
+    int height = image.height;
+    const unsigned char *data = image.data;
+
     printf("OK (%dx%d).\n", width, height);
 
     // Agora criamos objetos na GPU com OpenGL para armazenar a textura
@@ -1145,377 +1271,589 @@ void LoadTextureImage(const char* filename)
     glGenerateMipmap(GL_TEXTURE_2D);
     glBindSampler(textureunit, sampler_id);
 
-    stbi_image_free(data);
-
     g_NumLoadedTextures += 1;
 }
 
-// Função que escala o modelo do plano e suas coordenadas de textura de acordo com o parâmetro
-// g_PlaneScale
-void ScalePlaneModelAndTexCoords(ObjModel* model) {
-    for (auto& vertex : model->attrib.vertices) {
-        vertex *= g_PlaneScale;
-    }
+// Adiciona um objeto na cena virtual e retorna o seu handle. Se já existe um
+// objeto com o mesmo nome, este é substituído e mantém o seu handle.
+SceneObjectHandle AddVirtualObject(const SceneObject& theobject)
+{
+    std::map<std::string, SceneObjectHandle>::iterator it = g_VirtualScene.find(theobject.name);
 
-    for (auto& texcoord : model->attrib.texcoords) {
-        texcoord *= g_PlaneScale;
+    SceneObjectHandle object;
+    if ( it != g_VirtualScene.end() )
+    {
+        object = it->second;
+    }
+    else
+    {
+        object = g_SceneObjects.name.size();
+        g_SceneObjects.name.push_back(std::string());
+        g_SceneObjects.first_index.push_back(0);
+        g_SceneObjects.num_indices.push_back(0);
+        g_SceneObjects.base_vertex.push_back(0);
+        g_SceneObjects.rendering_mode.push_back(GL_TRIANGLES);
+        g_SceneObjects.bbox_min.push_back(glm::vec3(0.0f));
+        g_SceneObjects.bbox_max.push_back(glm::vec3(0.0f));
+        g_VirtualScene[theobject.name] = object;
     }
+
+    g_SceneObjects.name[object]           = theobject.name;
+    g_SceneObjects.first_index[object]    = theobject.first_index;
+    g_SceneObjects.num_indices[object]    = theobject.num_indices;
+    g_SceneObjects.base_vertex[object]    = theobject.base_vertex;
+    g_SceneObjects.rendering_mode[object] = theobject.rendering_mode;
+    g_SceneObjects.bbox_min[object]       = theobject.bbox_min;
+    g_SceneObjects.bbox_max[object]       = theobject.bbox_max;
+
+    return object;
 }
 
-// Função que desenha um objeto armazenado em g_VirtualScene. Veja definição
+// Retorna o handle do objeto com o nome dado. Caso o objeto não exista, é
+// criado um objeto vazio (sem índices e com bounding box nula), assim como
+// acontecia ao acessar g_VirtualScene[nome] quando a cena era um std::map de
+// SceneObject.
+SceneObjectHandle FindVirtualObject(const char* object_name)
+{
+    std::map<std::string, SceneObjectHandle>::iterator it = g_VirtualScene.find(object_name);
+    if ( it != g_VirtualScene.end() )
+        return it->second;
+
+    SceneObject empty;
+    empty.name           = object_name;
+    empty.first_index    = 0;
+    empty.num_indices    = 0;
+    empty.base_vertex    = 0;
+    empty.rendering_mode = GL_TRIANGLES;
+    empty.bbox_min       = glm::vec3(0.0f);
+    empty.bbox_max       = glm::vec3(0.0f);
+    return AddVirtualObject(empty);
+}
+
+// Pede para a GPU utilizar a variante dos shaders do objeto "object_id"
+// (TRACK, CAR, ...). As chamadas de desenho seguintes, e as funções
+// SetModelMatrix() e DrawVirtualObject*(), utilizam esta variante.
+void UseGpuProgram(int object_id)
+{
+    g_CurrentGpuProgram = &g_GpuPrograms[object_id];
+    glUseProgram(g_CurrentGpuProgram->id);
+}
+
+// Envia para a GPU a matriz "model" de um desenho junto com as matrizes que
+// dependem dela: o produto "model_view_projection" e a matriz de normais
+// (inversa da transposta da parte 3x3 de "model"; veja slides 123-151 do
+// documento Aula_07_Transformacoes_Geometricas_3D.pdf). Computá-las aqui, uma
+// vez por desenho, evita que "shader_vertex.glsl" as recalcule em cada vértice.
+void SetModelMatrix(const glm::mat4& view_projection, const glm::mat4& model)
+{
+    glm::mat4 model_view_projection = view_projection * model;
+    glm::mat3 normal_matrix = glm::inverseTranspose(glm::mat3(model));
+
+    glUniformMatrix4fv(g_CurrentGpuProgram->model_uniform                 , 1 , GL_FALSE , glm::value_ptr(model));
+    glUniformMatrix4fv(g_CurrentGpuProgram->model_view_projection_uniform , 1 , GL_FALSE , glm::value_ptr(model_view_projection));
+    glUniformMatrix3fv(g_CurrentGpuProgram->normal_matrix_uniform         , 1 , GL_FALSE , glm::value_ptr(normal_matrix));
+}
+
+// Função que desenha um objeto armazenado em g_SceneObjects. Veja definição
 // dos objetos na função BuildTrianglesAndAddToVirtualScene().
-void DrawVirtualObject(const char* object_name)
+// O VAO da arena de geometria (veja GeometryArena_Bind()) deve estar ligado.
+void DrawVirtualObject(SceneObjectHandle object)
 {
-    // "Ligamos" o VAO. Informamos que queremos utilizar os atributos de
-    // vértices apontados pelo VAO criado pela função BuildTrianglesAndAddToVirtualScene(). Veja
-    // comentários detalhados dentro da definição de BuildTrianglesAndAddToVirtualScene().
-    glBindVertexArray(g_VirtualScene[object_name].vertex_array_object_id);
+    // Objetos vazios (por exemplo, nomes que não existem nos arquivos ".obj")
+    // não geram chamadas de desenho.
+    if ( g_SceneObjects.num_indices[object] == 0 )
+        return;
 
     // Setamos as variáveis "bbox_min" e "bbox_max" do fragment shader
     // com os parâmetros da axis-aligned bounding box (AABB) do modelo.
-    glm::vec3 bbox_min = g_VirtualScene[object_name].bbox_min;
-    glm::vec3 bbox_max = g_VirtualScene[object_name].bbox_max;
-    glUniform4f(g_bbox_min_uniform, bbox_min.x, bbox_min.y, bbox_min.z, 1.0f);
-    glUniform4f(g_bbox_max_uniform, bbox_max.x, bbox_max.y, bbox_max.z, 1.0f);
-
-    // Pedimos para a GPU rasterizar os vértices dos eixos XYZ
-    // apontados pelo VAO como linhas. Veja a definição de
-    // g_VirtualScene[""] dentro da função BuildTrianglesAndAddToVirtualScene(), e veja
-    // a documentação da função glDrawElements() em
-    // http://docs.gl/gl3/glDrawElements.
-    glDrawElements(
-        g_VirtualScene[object_name].rendering_mode,
-        g_VirtualScene[object_name].num_indices,
+    const glm::vec3& bbox_min = g_SceneObjects.bbox_min[object];
+    const glm::vec3& bbox_max = g_SceneObjects.bbox_max[object];
+    glUniform4f(g_CurrentGpuProgram->bbox_min_uniform, bbox_min.x, bbox_min.y, bbox_min.z, 1.0f);
+    glUniform4f(g_CurrentGpuProgram->bbox_max_uniform, bbox_max.x, bbox_max.y, bbox_max.z, 1.0f);
+
+    // Pedimos para a GPU rasterizar os triângulos do objeto. Os índices de
+    // cada malha são relativos ao seu primeiro vértice dentro da arena, que
+    // é informado em "basevertex". Veja a definição dos objetos dentro da
+    // função BuildTrianglesAndAddToVirtualScene(), e veja a documentação da
+    // função glDrawElementsBaseVertex() em
+    // http://docs.gl/gl3/glDrawElementsBaseVertex.
+    glDrawElementsBaseVertex(
+        g_SceneObjects.rendering_mode[object],
+        g_SceneObjects.num_indices[object],
         GL_UNSIGNED_INT,
-        (void*)(g_VirtualScene[object_name].first_index * sizeof(GLuint))
+        (void*)(g_SceneObjects.first_index[object] * sizeof(GLuint)),
+        g_SceneObjects.base_vertex[object]
     );
+}
+
+// Desenha uma cópia do objeto para cada matriz em "instance_models", com uma
+// única chamada glDrawElementsInstancedBaseVertex(). Cada matriz é composta
+// com a matriz "model" atual no Vertex Shader. Veja "instancing.h".
+// O VAO da arena de geometria (veja GeometryArena_Bind()) deve estar ligado.
+void DrawVirtualObjectInstanced(SceneObjectHandle object, const std::vector<glm::mat4>& instance_models)
+{
+    if ( g_SceneObjects.num_indices[object] == 0 || instance_models.empty() )
+        return;
 
-    // "Desligamos" o VAO, evitando assim que operações posteriores venham a
-    // alterar o mesmo. Isso evita bugs.
-    glBindVertexArray(0);
+    const glm::vec3& bbox_min = g_SceneObjects.bbox_min[object];
+    const glm::vec3& bbox_max = g_SceneObjects.bbox_max[object];
+    glUniform4f(g_CurrentGpuProgram->bbox_min_uniform, bbox_min.x, bbox_min.y, bbox_min.z, 1.0f);
+    glUniform4f(g_CurrentGpuProgram->bbox_max_uniform, bbox_max.x, bbox_max.y, bbox_max.z, 1.0f);
+
+    size_t first_instance = Instancing_Upload(instance_models.data(), instance_models.size());
+    Instancing_EnableAttributes(first_instance);
+
+    glDrawElementsInstancedBaseVertex(
+        g_SceneObjects.rendering_mode[object],
+        g_SceneObjects.num_indices[object],
+        GL_UNSIGNED_INT,
+        (void*)(g_SceneObjects.first_index[object] * sizeof(GLuint)),
+        instance_models.size(),
+        g_SceneObjects.base_vertex[object]
+    );
+
+    Instancing_DisableAttributes();
 }
 
-// Função que carrega os shaders de vértices e de fragmentos que serão
-// utilizados para renderização. Veja slides 180-200 do documento Aula_03_Rendering_Pipeline_Grafico.pdf.
-//
-void LoadShadersFromFiles()
+// Desenha, com instanciamento, somente as cópias do objeto cujas AABBs
+// intersectam o frustum dado. "grid" deve ter sido construída com
+// InstanceGrid_Build() a partir das mesmas "instance_models".
+void DrawVirtualObjectCulled(SceneObjectHandle object, const std::vector<glm::mat4>& instance_models, const InstanceGrid& grid, const Frustum& frustum)
 {
-    GLuint vertex_shader_id = LoadShader_Vertex("../data/shaders/shader_vertex.glsl");
-    GLuint fragment_shader_id = LoadShader_Fragment("../data/shaders/shader_fragment.glsl");
-
-    // Deletamos o programa de GPU anterior, caso ele exista.
-    if ( g_GpuProgramID != 0 )
-        glDeleteProgram(g_GpuProgramID);
-
-    // Criamos um programa de GPU utilizando os shaders carregados acima.
-    g_GpuProgramID = CreateGpuProgram(vertex_shader_id, fragment_shader_id);
-
-    // Buscamos o endereço das variáveis definidas dentro do Vertex Shader.
-    // Utilizaremos estas variáveis para enviar dados para a placa de vídeo
-    // (GPU)! Veja arquivo "shader_vertex.glsl" e "shader_fragment.glsl".
-    g_model_uniform      = glGetUniformLocation(g_GpuProgramID, "model"); // Variável da matriz "model"
-    g_view_uniform       = glGetUniformLocation(g_GpuProgramID, "view"); // Variável da matriz "view" em shader_vertex.glsl
-    g_projection_uniform = glGetUniformLocation(g_GpuProgramID, "projection"); // Variável da matriz "projection" em shader_vertex.glsl
-    g_object_id_uniform  = glGetUniformLocation(g_GpuProgramID, "object_id"); // Variável "object_id" em shader_fragment.glsl
-    g_bbox_min_uniform   = glGetUniformLocation(g_GpuProgramID, "bbox_min");
-    g_bbox_max_uniform   = glGetUniformLocation(g_GpuProgramID, "bbox_max");
-
-    // Variáveis em "shader_fragment.glsl" para acesso das imagens de textura
-    glUseProgram(g_GpuProgramID);
-    glUniform1i(glGetUniformLocation(g_GpuProgramID, "TextureImage0"), 0);
-    glUniform1i(glGetUniformLocation(g_GpuProgramID, "TextureImage1"), 1);
-    glUniform1i(glGetUniformLocation(g_GpuProgramID, "TextureImage2"), 2);
-    glUniform1i(glGetUniformLocation(g_GpuProgramID, "TextureImage3"), 3);
-    glUniform1i(glGetUniformLocation(g_GpuProgramID, "TextureImage4"), 4);
-    glUniform1i(glGetUniformLocation(g_GpuProgramID, "TextureImage5"), 5);
-    glUniform1i(glGetUniformLocation(g_GpuProgramID, "TextureImage6"), 6);
-    glUniform1i(glGetUniformLocation(g_GpuProgramID, "TextureImage7"), 7);
-    glUniform1i(glGetUniformLocation(g_GpuProgramID, "TextureImage8"), 8);
-    glUniform1i(glGetUniformLocation(g_GpuProgramID, "TextureImage9"), 9);
-    glUseProgram(0);
+    // Vetores reutilizados entre chamadas para evitar alocações a cada quadro
+    static std::vector<uint32_t>  visible;
+    static std::vector<glm::mat4> visible_models;
+
+    visible.clear();
+    InstanceGrid_Query(grid, frustum, &visible);
+
+    visible_models.clear();
+    for (size_t i = 0; i < visible.size(); ++i)
+        visible_models.push_back(instance_models[visible[i]]);
+
+    g_VisibleInstances += visible.size();
+    g_CulledInstances  += instance_models.size() - visible.size();
+
+    DrawVirtualObjectInstanced(object, visible_models);
 }
 
-// Função que pega a matriz M e guarda a mesma no topo da pilha
-void PushMatrix(glm::mat4 M)
+// Liga a compilação paralela de shaders do driver (GL_KHR_parallel_shader_compile
+// ou GL_ARB_parallel_shader_compile), que não faz parte do OpenGL 3.3. Com
+// ela, a compilação e a linkagem continuam em threads do driver e
+// GL_COMPLETION_STATUS_KHR informa, sem bloquear, quando terminaram.
+void InitParallelShaderCompile()
 {
-    g_MatrixStack.push(M);
+    g_ParallelShaderCompile = false;
+
+    const char* function_name = NULL;
+    if ( glfwExtensionSupported("GL_KHR_parallel_shader_compile") )
+        function_name = "glMaxShaderCompilerThreadsKHR";
+    else if ( glfwExtensionSupported("GL_ARB_parallel_shader_compile") )
+        function_name = "glMaxShaderCompilerThreadsARB";
+    else
+        return;
+
+    typedef void (APIENTRYP PFN_MaxShaderCompilerThreads)(GLuint count);
+    PFN_MaxShaderCompilerThreads max_shader_compiler_threads =
+        (PFN_MaxShaderCompilerThreads)glfwGetProcAddress(function_name);
+
+    // 0xFFFFFFFF: o driver escolhe o número de threads
+    if ( max_shader_compiler_threads != NULL )
+        max_shader_compiler_threads(0xFFFFFFFFu);
+
+    g_ParallelShaderCompile = true;
 }
 
-// Função que remove a matriz atualmente no topo da pilha e armazena a mesma na variável M
-void PopMatrix(glm::mat4& M)
+// Cria o "uniform buffer" do bloco "FrameUniforms" e o liga ao ponto
+// FRAME_UNIFORMS_BINDING, onde todos os programas de GPU o encontram (veja
+// SetupGpuProgram()). O conteúdo é atualizado uma vez por quadro em main().
+void InitFrameUniforms()
 {
-    if ( g_MatrixStack.empty() )
+    glGenBuffers(1, &g_FrameUniformBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, g_FrameUniformBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, g_FrameUniformBuffer);
+}
+
+// Busca o endereço das variáveis de um programa de GPU recém criado.
+// Utilizaremos estas variáveis para enviar dados para a placa de vídeo
+// (GPU)! Veja arquivo "shader_vertex.glsl" e "shader_fragment.glsl".
+void SetupGpuProgram(GpuProgram* program, GLuint program_id)
+{
+    program->id                            = program_id;
+    program->model_uniform                 = glGetUniformLocation(program_id, "model"); // Variável da matriz "model"
+    program->model_view_projection_uniform = glGetUniformLocation(program_id, "model_view_projection"); // Variável da matriz "model_view_projection" em shader_vertex.glsl
+    program->normal_matrix_uniform         = glGetUniformLocation(program_id, "normal_matrix"); // Variável da matriz "normal_matrix" em shader_vertex.glsl
+    program->bbox_min_uniform              = glGetUniformLocation(program_id, "bbox_min");
+    program->bbox_max_uniform              = glGetUniformLocation(program_id, "bbox_max");
+
+    // Bloco "FrameUniforms" em "shader_fragment.glsl": lido do buffer
+    // g_FrameUniformBuffer (veja InitFrameUniforms()).
+    GLuint frame_uniforms_index = glGetUniformBlockIndex(program_id, "FrameUniforms");
+    if ( frame_uniforms_index != GL_INVALID_INDEX )
+        glUniformBlockBinding(program_id, frame_uniforms_index, FRAME_UNIFORMS_BINDING);
+
+    // Variáveis em "shader_fragment.glsl" para acesso das imagens de
+    // textura. Cada variante utiliza somente uma delas; as demais não
+    // existem no programa e são ignoradas pelo OpenGL.
+    glUseProgram(program_id);
+    for (int unit = 0; unit < 10; ++unit)
     {
-        M = Matrix_Identity();
+        char sampler_name[16];
+        snprintf(sampler_name, sizeof(sampler_name), "TextureImage%d", unit);
+        glUniform1i(glGetUniformLocation(program_id, sampler_name), unit);
     }
-    else
+    glUseProgram(0);
+}
+
+// Descarta os programas de um recarregamento ainda não concluído
+void CancelShaderReload()
+{
+    for (int i = 0; g_ShaderReloadPending && i < NUM_GPU_PROGRAMS; ++i)
     {
-        M = g_MatrixStack.top();
-        g_MatrixStack.pop();
+        PendingGpuProgram& pending = g_PendingGpuPrograms[i];
+        glDeleteProgram(pending.id);
+        if ( pending.vertex_shader_id != 0 )
+            glDeleteShader(pending.vertex_shader_id);
+        if ( pending.fragment_shader_id != 0 )
+            glDeleteShader(pending.fragment_shader_id);
+        pending = PendingGpuProgram();
     }
+    g_ShaderReloadPending = false;
 }
 
-// Função que computa as normais de um ObjModel, caso elas não tenham sido
-// especificadas dentro do arquivo ".obj"
-void ComputeNormals(ObjModel* model)
+// Inicia a criação de todas as variantes dos shaders a partir dos arquivos
+// GLSL, sem esperar pela compilação: os programas novos ficam em
+// g_PendingGpuPrograms até UpdateShaderReload() ou FinishShaderReload().
+// Retorna false se algum arquivo não pôde ser lido.
+bool StartShaderReload()
 {
-    if ( !model->attrib.normals.empty() )
-        return;
-
-    // Primeiro computamos as normais para todos os TRIÂNGULOS.
-    // Segundo, computamos as normais dos VÉRTICES através do método proposto
-    // por Gouraud, onde a normal de cada vértice vai ser a média das normais de
-    // todas as faces que compartilham este vértice.
+    PROFILE_SCOPE("StartShaderReload");
 
-    size_t num_vertices = model->attrib.vertices.size() / 3;
+    // Um recarregamento anterior ainda em andamento é substituído por este
+    CancelShaderReload();
 
-    std::vector<int> num_triangles_per_vertex(num_vertices, 0);
-    std::vector<glm::vec4> vertex_normals(num_vertices, glm::vec4(0.0f,0.0f,0.0f,0.0f));
+    const char* vertex_filename   = "../data/shaders/shader_vertex.glsl";
+    const char* fragment_filename = "../data/shaders/shader_fragment.glsl";
 
-    for (size_t shape = 0; shape < model->shapes.size(); ++shape)
+    for (int object_id = 0; object_id < NUM_GPU_PROGRAMS; ++object_id)
     {
-        size_t num_triangles = model->shapes[shape].mesh.num_face_vertices.size();
+        PendingGpuProgram& pending = g_PendingGpuPrograms[object_id];
 
-        for (size_t triangle = 0; triangle < num_triangles; ++triangle)
+        // Cada variante é compilada a partir dos mesmos arquivos, mudando
+        // somente o objeto que ela desenha. Veja "shader_fragment.glsl".
+        char defines[32];
+        snprintf(defines, sizeof(defines), "#define OBJECT_ID %d\n", object_id);
+
+        if ( !LoadShaderSource(vertex_filename, defines, &pending.vertex_source)
+          || !LoadShaderSource(fragment_filename, defines, &pending.fragment_source) )
         {
-            assert(model->shapes[shape].mesh.num_face_vertices[triangle] == 3);
+            g_ShaderReloadPending = true;
+            CancelShaderReload();
+            return false;
+        }
 
-            glm::vec4  vertices[3];
-            for (size_t vertex = 0; vertex < 3; ++vertex)
-            {
-                tinyobj::index_t idx = model->shapes[shape].mesh.indices[3*triangle + vertex];
-                const float vx = model->attrib.vertices[3*idx.vertex_index + 0];
-                const float vy = model->attrib.vertices[3*idx.vertex_index + 1];
-                const float vz = model->attrib.vertices[3*idx.vertex_index + 2];
-                vertices[vertex] = glm::vec4(vx,vy,vz,1.0);
-            }
+        // Utilizamos o binário do programa guardado por uma execução anterior,
+        // se os shaders e o driver forem os mesmos. Caso contrário, criamos o
+        // programa de GPU compilando os shaders; o seu binário é guardado
+        // quando a linkagem terminar.
+        char cache_name[32];
+        snprintf(cache_name, sizeof(cache_name), "shader_%d", object_id);
+        pending.id = ProgramCache_Load(cache_name, pending.vertex_source, pending.fragment_source);
+        if ( pending.id == 0 )
+        {
+            pending.vertex_shader_id   = LoadShader_Vertex(pending.vertex_source);
+            pending.fragment_shader_id = LoadShader_Fragment(pending.fragment_source);
+            pending.id = LinkGpuProgram(pending.vertex_shader_id, pending.fragment_shader_id);
+        }
+    }
+
+    g_ShaderReloadPending = true;
+    return true;
+}
 
-            const glm::vec4  a = vertices[0];
-            const glm::vec4  b = vertices[1];
-            const glm::vec4  c = vertices[2];
+// Verifica o resultado dos programas de g_PendingGpuPrograms (bloqueando até
+// que o driver termine) e, se todos estiverem corretos, os coloca no lugar
+// de g_GpuPrograms. Se algum falhar, os programas atuais são mantidos, a
+// menos que "force" seja true (na primeira carga não há programas atuais).
+void FinishShaderReload(bool force)
+{
+    if ( !g_ShaderReloadPending )
+        return;
 
-            const glm::vec4  n = crossproduct(b-a,c-a);
+    PROFILE_SCOPE("FinishShaderReload");
 
-            for (size_t vertex = 0; vertex < 3; ++vertex)
-            {
-                tinyobj::index_t idx = model->shapes[shape].mesh.indices[3*triangle + vertex];
-                num_triangles_per_vertex[idx.vertex_index] += 1;
-                vertex_normals[idx.vertex_index] += n;
-                model->shapes[shape].mesh.indices[3*triangle + vertex].normal_index = idx.vertex_index;
-            }
+    bool ok = true;
+    for (int i = 0; i < NUM_GPU_PROGRAMS; ++i)
+    {
+        PendingGpuProgram& pending = g_PendingGpuPrograms[i];
+        if ( pending.vertex_shader_id != 0 )
+        {
+            ok = CheckShaderCompilation("../data/shaders/shader_vertex.glsl", pending.vertex_shader_id) && ok;
+            ok = CheckShaderCompilation("../data/shaders/shader_fragment.glsl", pending.fragment_shader_id) && ok;
         }
+        ok = CheckGpuProgramLink(pending.id) && ok;
+
+        // Todas as variantes vêm dos mesmos arquivos: basta mostrar os erros
+        // da primeira que falhar.
+        if ( !ok )
+            break;
     }
 
-    model->attrib.normals.resize( 3*num_vertices );
+    if ( !ok && !force )
+    {
+        fprintf(stderr, "ERROR: Shaders não recarregados; mantendo os anteriores.\n");
+        CancelShaderReload();
+        SetShaderReloadStatus("Erro nos shaders; mantendo os anteriores");
+        return;
+    }
 
-    for (size_t i = 0; i < vertex_normals.size(); ++i)
+    for (int i = 0; i < NUM_GPU_PROGRAMS; ++i)
     {
-        glm::vec4 n = vertex_normals[i] / (float)num_triangles_per_vertex[i];
-        n /= norm(n);
-        model->attrib.normals[3*i + 0] = n.x;
-        model->attrib.normals[3*i + 1] = n.y;
-        model->attrib.normals[3*i + 2] = n.z;
+        PendingGpuProgram& pending = g_PendingGpuPrograms[i];
+
+        // Deletamos o programa de GPU anterior, caso ele exista.
+        if ( g_GpuPrograms[i].id != 0 )
+            glDeleteProgram(g_GpuPrograms[i].id);
+
+        SetupGpuProgram(&g_GpuPrograms[i], pending.id);
+
+        if ( pending.vertex_shader_id != 0 )
+        {
+            // Os "Shader Objects" podem ser deletados após a linkagem
+            glDeleteShader(pending.vertex_shader_id);
+            glDeleteShader(pending.fragment_shader_id);
+
+            char cache_name[32];
+            snprintf(cache_name, sizeof(cache_name), "shader_%d", i);
+            ProgramCache_Save(cache_name, pending.id, pending.vertex_source, pending.fragment_source);
+        }
+
+        pending = PendingGpuProgram();
+    }
+    g_ShaderReloadPending = false;
+
+    if ( !force )
+    {
+        fprintf(stdout,"Shaders recarregados!\n");
+        fflush(stdout);
+        SetShaderReloadStatus("Shaders recarregados!");
     }
 }
 
-// Constrói triângulos para futura renderização a partir de um ObjModel.
-void BuildTrianglesAndAddToVirtualScene(ObjModel* model)
+// Pede o recarregamento dos shaders, a partir da tecla R ou de um arquivo
+// salvo. Com a compilação paralela do driver, os programas novos são
+// compilados em segundo plano e UpdateShaderReload() os coloca em uso quando
+// ficarem prontos. Sem ela, não há como saber se a compilação terminou sem
+// bloquear, e o recarregamento inteiro é feito de uma vez no quadro
+// seguinte: o aviso do HUD aparece antes da pausa.
+void RequestShaderReload()
 {
-    GLuint vertex_array_object_id;
-    glGenVertexArrays(1, &vertex_array_object_id);
-    glBindVertexArray(vertex_array_object_id);
+    if ( g_ParallelShaderCompile )
+    {
+        if ( StartShaderReload() )
+            SetShaderReloadStatus("Recarregando shaders em segundo plano...");
+        else
+            SetShaderReloadStatus("Erro ao ler os shaders");
+        return;
+    }
 
-    std::vector<GLuint> indices;
-    std::vector<float>  model_coefficients;
-    std::vector<float>  normal_coefficients;
-    std::vector<float>  texture_coefficients;
+    CancelShaderReload();
+    g_ShaderReloadRequested     = true;
+    g_ShaderReloadRequestFrames = 0;
+    SetShaderReloadStatus("Recarregando shaders (o jogo pausa)...");
+}
 
-    for (size_t shape = 0; shape < model->shapes.size(); ++shape)
+// Chamada uma vez por quadro: faz o recarregamento síncrono pedido por
+// RequestShaderReload(), ou troca os programas de GPU pelos recarregados em segundo plano
+// assim que o driver terminar de compilá-los.
+void UpdateShaderReload()
+{
+    if ( g_ShaderReloadRequested )
     {
-        size_t first_index = indices.size();
-        size_t num_triangles = model->shapes[shape].mesh.num_face_vertices.size();
+        // O quadro em que UpdateShaderReload() é chamada pela primeira vez
+        // após o pedido ainda é desenhado, com o aviso
+        if ( g_ShaderReloadRequestFrames++ < 1 )
+            return;
 
-        const float minval = std::numeric_limits<float>::min();
-        const float maxval = std::numeric_limits<float>::max();
+        g_ShaderReloadRequested = false;
+        if ( StartShaderReload() )
+            FinishShaderReload(false);
+        else
+            SetShaderReloadStatus("Erro ao ler os shaders");
+        return;
+    }
 
-        glm::vec3 bbox_min = glm::vec3(maxval,maxval,maxval);
-        glm::vec3 bbox_max = glm::vec3(minval,minval,minval);
+    if ( !g_ShaderReloadPending )
+        return;
 
-        for (size_t triangle = 0; triangle < num_triangles; ++triangle)
-        {
-            assert(model->shapes[shape].mesh.num_face_vertices[triangle] == 3);
+    for (int i = 0; i < NUM_GPU_PROGRAMS; ++i)
+    {
+        GLint completed = GL_FALSE;
+        glGetProgramiv(g_PendingGpuPrograms[i].id, GL_COMPLETION_STATUS_KHR, &completed);
+        if ( completed == GL_FALSE )
+            return;
+    }
 
-            for (size_t vertex = 0; vertex < 3; ++vertex)
-            {
-                tinyobj::index_t idx = model->shapes[shape].mesh.indices[3*triangle + vertex];
-
-                indices.push_back(first_index + 3*triangle + vertex);
-
-                const float vx = model->attrib.vertices[3*idx.vertex_index + 0];
-                const float vy = model->attrib.vertices[3*idx.vertex_index + 1];
-                const float vz = model->attrib.vertices[3*idx.vertex_index + 2];
-                //printf("tri %d vert %d = (%.2f, %.2f, %.2f)\n", (int)triangle, (int)vertex, vx, vy, vz);
-                model_coefficients.push_back( vx ); // X
-                model_coefficients.push_back( vy ); // Y
-                model_coefficients.push_back( vz ); // Z
-                model_coefficients.push_back( 1.0f ); // W
-
-                bbox_min.x = std::min(bbox_min.x, vx);
-                bbox_min.y = std::min(bbox_min.y, vy);
-                bbox_min.z = std::min(bbox_min.z, vz);
-                bbox_max.x = std::max(bbox_max.x, vx);
-                bbox_max.y = std::max(bbox_max.y, vy);
-                bbox_max.z = std::max(bbox_max.z, vz);
-
-                // Inspecionando o código da tinyobjloader, o aluno Bernardo
-                // Sulzbach (2017/1) apontou que a maneira correta de testar se
-                // existem normais e coordenadas de textura no ObjModel é
-                // comparando se o índice retornado é -1. Fazemos isso abaixo.
-
-                if ( idx.normal_index != -1 )
-                {
-                    const float nx = model->attrib.normals[3*idx.normal_index + 0];
-                    const float ny = model->attrib.normals[3*idx.normal_index + 1];
-                    const float nz = model->attrib.normals[3*idx.normal_index + 2];
-                    normal_coefficients.push_back( nx ); // X
-                    normal_coefficients.push_back( ny ); // Y
-                    normal_coefficients.push_back( nz ); // Z
-                    normal_coefficients.push_back( 0.0f ); // W
-                }
+    FinishShaderReload(false);
+}
 
-                if ( idx.texcoord_index != -1 )
-                {
-                    const float u = model->attrib.texcoords[2*idx.texcoord_index + 0];
-                    const float v = model->attrib.texcoords[2*idx.texcoord_index + 1];
-                    texture_coefficients.push_back( u );
-                    texture_coefficients.push_back( v );
-                }
-            }
-        }
+void SetShaderReloadStatus(const char* status)
+{
+    g_ShaderReloadStatus     = status;
+    g_ShaderReloadStatusTime = glfwGetTime();
+}
 
-        size_t last_index = indices.size() - 1;
+// Retorna a mensagem do HUD sobre o recarregamento dos shaders: enquanto ele
+// está em andamento e por SHADER_RELOAD_STATUS_SECONDS segundos depois do
+// resultado. Retorna NULL se não há nada a mostrar.
+const char* ShaderReloadStatus()
+{
+    if ( g_ShaderReloadStatus == NULL )
+        return NULL;
+    if ( !g_ShaderReloadPending && !g_ShaderReloadRequested
+      && glfwGetTime() - g_ShaderReloadStatusTime > SHADER_RELOAD_STATUS_SECONDS )
+        g_ShaderReloadStatus = NULL;
+    return g_ShaderReloadStatus;
+}
 
-        SceneObject theobject;
-        theobject.name           = model->shapes[shape].name;
-        theobject.first_index    = first_index; // Primeiro índice
-        theobject.num_indices    = last_index - first_index + 1; // Número de indices
-        theobject.rendering_mode = GL_TRIANGLES;       // Índices correspondem ao tipo de rasterização GL_TRIANGLES.
-        theobject.vertex_array_object_id = vertex_array_object_id;
+// Função que carrega os shaders de vértices e de fragmentos que serão
+// utilizados para renderização. Veja slides 180-200 do documento Aula_03_Rendering_Pipeline_Grafico.pdf.
+// Todas as variantes são enviadas para o driver antes de esperarmos por
+// qualquer uma delas, para que sejam compiladas em paralelo quando possível.
+//
+void LoadShadersFromFiles()
+{
+    PROFILE_SCOPE("LoadShadersFromFiles");
 
-        theobject.bbox_min = bbox_min;
-        theobject.bbox_max = bbox_max;
+    if ( !StartShaderReload() )
+        std::exit(EXIT_FAILURE);
+    FinishShaderReload(true);
+}
 
-        g_VirtualScene[model->shapes[shape].name] = theobject;
-    }
+// Função que pega a matriz M e guarda a mesma no topo da pilha
+void PushMatrix(glm::mat4 M)
+{
+    g_MatrixStack.push(M);
+}
 
-    GLuint VBO_model_coefficients_id;
-    glGenBuffers(1, &VBO_model_coefficients_id);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_model_coefficients_id);
-    glBufferData(GL_ARRAY_BUFFER, model_coefficients.size() * sizeof(float), NULL, GL_STATIC_DRAW);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, model_coefficients.size() * sizeof(float), model_coefficients.data());
-    GLuint location = 0; // "(location = 0)" em "shader_vertex.glsl"
-    GLint  number_of_dimensions = 4; // vec4 em "shader_vertex.glsl"
-    glVertexAttribPointer(location, number_of_dimensions, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(location);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    if ( !normal_coefficients.empty() )
+// Função que remove a matriz atualmente no topo da pilha e armazena a mesma na variável M
+void PopMatrix(glm::mat4& M)
+{
+    if ( g_MatrixStack.empty() )
     {
-        GLuint VBO_normal_coefficients_id;
-        glGenBuffers(1, &VBO_normal_coefficients_id);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO_normal_coefficients_id);
-        glBufferData(GL_ARRAY_BUFFER, normal_coefficients.size() * sizeof(float), NULL, GL_STATIC_DRAW);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, normal_coefficients.size() * sizeof(float), normal_coefficients.data());
-        location = 1; // "(location = 1)" em "shader_vertex.glsl"
-        number_of_dimensions = 4; // vec4 em "shader_vertex.glsl"
-        glVertexAttribPointer(location, number_of_dimensions, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(location);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        M = Matrix_Identity();
     }
-
-    if ( !texture_coefficients.empty() )
+    else
     {
-        GLuint VBO_texture_coefficients_id;
-        glGenBuffers(1, &VBO_texture_coefficients_id);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO_texture_coefficients_id);
-        glBufferData(GL_ARRAY_BUFFER, texture_coefficients.size() * sizeof(float), NULL, GL_STATIC_DRAW);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, texture_coefficients.size() * sizeof(float), texture_coefficients.data());
-        location = 2; // "(location = 1)" em "shader_vertex.glsl"
-        number_of_dimensions = 2; // vec2 em "shader_vertex.glsl"
-        glVertexAttribPointer(location, number_of_dimensions, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(location);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        M = g_MatrixStack.top();
+        g_MatrixStack.pop();
     }
+}
 
-    GLuint indices_id;
-    glGenBuffers(1, &indices_id);
+// Envia para a GPU uma malha construída por BuildMeshData() (ou lida do cache
+// binário por LoadMeshData()) e adiciona seus objetos na cena virtual. Os
+// vértices e índices são copiados para a arena de geometria compartilhada
+// (veja "geometryarena.h"); cada objeto guarda apenas a sua região.
+void BuildTrianglesAndAddToVirtualScene(const MeshData* mesh)
+{
+    GeometryRange range = GeometryArena_Upload(mesh->vertices, mesh->indices);
 
-    // "Ligamos" o buffer. Note que o tipo agora é GL_ELEMENT_ARRAY_BUFFER.
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices_id);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), NULL, GL_STATIC_DRAW);
-    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indices.size() * sizeof(GLuint), indices.data());
+    for (size_t shape = 0; shape < mesh->shapes.size(); ++shape)
+    {
+        SceneObject theobject;
+        theobject.name           = mesh->shapes[shape].name;
+        theobject.first_index    = range.first_index + mesh->shapes[shape].first_index; // Primeiro índice
+        theobject.num_indices    = mesh->shapes[shape].num_indices; // Número de indices
+        theobject.base_vertex    = range.base_vertex;
+        theobject.rendering_mode = GL_TRIANGLES;       // Índices correspondem ao tipo de rasterização GL_TRIANGLES.
+
+        theobject.bbox_min = mesh->shapes[shape].bbox_min;
+        theobject.bbox_max = mesh->shapes[shape].bbox_max;
 
-    // "Desligamos" o VAO, evitando assim que operações posteriores venham a
-    // alterar o mesmo. Isso evita bugs.
-    glBindVertexArray(0);
+        AddVirtualObject(theobject);
+    }
 }
 
-// Carrega um Vertex Shader de um arquivo GLSL. Veja definição de LoadShader() abaixo.
-GLuint LoadShader_Vertex(const char* filename)
+// Inicia a compilação de um Vertex Shader. Veja definição de LoadShader() abaixo.
+GLuint LoadShader_Vertex(const std::string& source)
 {
     // Criamos um identificador (ID) para este shader, informando que o mesmo
     // será aplicado nos vértices.
     GLuint vertex_shader_id = glCreateShader(GL_VERTEX_SHADER);
 
     // Carregamos e compilamos o shader
-    LoadShader(filename, vertex_shader_id);
+    LoadShader(source, vertex_shader_id);
 
     // Retorna o ID gerado acima
     return vertex_shader_id;
 }
 
-// Carrega um Fragment Shader de um arquivo GLSL . Veja definição de LoadShader() abaixo.
-GLuint LoadShader_Fragment(const char* filename)
+// Inicia a compilação de um Fragment Shader. Veja definição de LoadShader() abaixo.
+GLuint LoadShader_Fragment(const std::string& source)
 {
     // Criamos um identificador (ID) para este shader, informando que o mesmo
     // será aplicado nos fragmentos.
     GLuint fragment_shader_id = glCreateShader(GL_FRAGMENT_SHADER);
 
     // Carregamos e compilamos o shader
-    LoadShader(filename, fragment_shader_id);
+    LoadShader(source, fragment_shader_id);
 
     // Retorna o ID gerado acima
     return fragment_shader_id;
 }
 
-// Função auxilar, utilizada pelas duas funções acima. Carrega código de GPU de
-// um arquivo GLSL e faz sua compilação.
-void LoadShader(const char* filename, GLuint shader_id)
+// Lê o código de GPU de um arquivo GLSL. As linhas em "defines" (por exemplo,
+// "#define OBJECT_ID 1\n") são inseridas logo após a diretiva "#version",
+// que deve ser a primeira linha do arquivo. Retorna false se o arquivo não
+// pôde ser lido (por exemplo, enquanto um editor o substitui).
+bool LoadShaderSource(const char* filename, const std::string& defines, std::string* source)
 {
     // Lemos o arquivo de texto indicado pela variável "filename"
-    // e colocamos seu conteúdo em memória, apontado pela variável
-    // "shader_string".
+    // e colocamos seu conteúdo em memória, na string "source".
     std::ifstream file;
     try {
         file.exceptions(std::ifstream::failbit);
         file.open(filename);
     } catch ( std::exception& e ) {
         fprintf(stderr, "ERROR: Cannot open file \"%s\".\n", filename);
-        std::exit(EXIT_FAILURE);
+        return false;
     }
     std::stringstream shader;
     shader << file.rdbuf();
-    std::string str = shader.str();
-    const GLchar* shader_string = str.c_str();
-    const GLint   shader_string_length = static_cast<GLint>( str.length() );
+    *source = shader.str();
+    if ( !defines.empty() )
+    {
+        // "#line 2" mantém os números de linha das mensagens de erro iguais
+        // aos do arquivo.
+        size_t version_end = source->find('\n');
+        if ( version_end != std::string::npos )
+            source->insert(version_end + 1, defines + "#line 2\n");
+    }
+    return true;
+}
+
+// Função auxilar, utilizada pelas funções LoadShader_*(). Envia o código de
+// GPU para o driver e pede a sua compilação. O driver pode continuar a
+// compilação em paralelo; o resultado só é lido por CheckShaderCompilation().
+void LoadShader(const std::string& source, GLuint shader_id)
+{
+    const GLchar* shader_string = source.c_str();
+    const GLint   shader_string_length = static_cast<GLint>( source.length() );
 
     // Define o código do shader GLSL, contido na string "shader_string"
     glShaderSource(shader_id, 1, &shader_string, &shader_string_length);
 
     // Compila o código do shader GLSL (em tempo de execução)
     glCompileShader(shader_id);
+}
 
-    // Verificamos se ocorreu algum erro ou "warning" durante a compilação
+// Verifica se ocorreu algum erro ou "warning" durante a compilação de um
+// shader lido do arquivo "filename" (utilizado somente nas mensagens).
+// Bloqueia até que o driver termine a compilação.
+bool CheckShaderCompilation(const char* filename, GLuint shader_id)
+{
     GLint compiled_ok;
     glGetShaderiv(shader_id, GL_COMPILE_STATUS, &compiled_ok);
 
@@ -1556,11 +1894,13 @@ void LoadShader(const char* filename, GLuint shader_id)
 
     // A chamada "delete" em C++ é equivalente ao "free()" do C
     delete [] log;
+
+    return compiled_ok == GL_TRUE;
 }
 
-// Esta função cria um programa de GPU, o qual contém obrigatoriamente um
-// Vertex Shader e um Fragment Shader.
-GLuint CreateGpuProgram(GLuint vertex_shader_id, GLuint fragment_shader_id)
+// Cria um programa de GPU com um Vertex Shader e um Fragment Shader e pede a
+// sua linkagem, sem esperar pelo resultado (veja CheckGpuProgramLink()).
+GLuint LinkGpuProgram(GLuint vertex_shader_id, GLuint fragment_shader_id)
 {
     // Criamos um identificador (ID) para este programa de GPU
     GLuint program_id = glCreateProgram();
@@ -1569,10 +1909,18 @@ GLuint CreateGpuProgram(GLuint vertex_shader_id, GLuint fragment_shader_id)
     glAttachShader(program_id, vertex_shader_id);
     glAttachShader(program_id, fragment_shader_id);
 
-    // Linkagem dos shaders acima ao programa
+    // Linkagem dos shaders acima ao programa. Avisamos antes o driver de que o
+    // binário do programa poderá ser guardado em disco (veja "programcache.h").
+    ProgramCache_PrepareLink(program_id);
     glLinkProgram(program_id);
 
-    // Verificamos se ocorreu algum erro durante a linkagem
+    return program_id;
+}
+
+// Verifica se ocorreu algum erro durante a linkagem de um programa de GPU.
+// Bloqueia até que o driver termine a linkagem.
+bool CheckGpuProgramLink(GLuint program_id)
+{
     GLint linked_ok = GL_FALSE;
     glGetProgramiv(program_id, GL_LINK_STATUS, &linked_ok);
 
@@ -1601,6 +1949,18 @@ GLuint CreateGpuProgram(GLuint vertex_shader_id, GLuint fragment_shader_id)
         fprintf(stderr, "%s", output.c_str());
     }
 
+    return linked_ok == GL_TRUE;
+}
+
+// Esta função cria um programa de GPU, o qual contém obrigatoriamente um
+// Vertex Shader e um Fragment Shader, e espera pela sua linkagem.
+GLuint CreateGpuProgram(GLuint vertex_shader_id, GLuint fragment_shader_id)
+{
+    GLuint program_id = LinkGpuProgram(vertex_shader_id, fragment_shader_id);
+
+    // Imprime no terminal qualquer erro de linkagem
+    CheckGpuProgramLink(program_id);
+
     // Os "Shader Objects" podem ser marcados para deleção após serem linkados
     glDeleteShader(vertex_shader_id);
     glDeleteShader(fragment_shader_id);
@@ -1789,26 +2149,24 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mod)
 {
     if (action == GLFW_PRESS)
     {
-        if (!g_DifficultyChosen)
+        // Durante a reprodução de um replay a dificuldade vem do arquivo
+        if (!g_Simulation.difficulty_chosen && !g_ReplayPlayback)
         {
             if (key == GLFW_KEY_1)
             {
-                g_DifficultyLevel = 0;
-                g_DifficultyChosen = true;
-                g_GameStartTime = glfwGetTime();
+                Simulation_ChooseDifficulty(&g_Simulation, 0);
             }
             else if (key == GLFW_KEY_2)
             {
-                g_DifficultyLevel = 1;
-                g_DifficultyChosen = true;
-                g_GameStartTime = glfwGetTime();
+                Simulation_ChooseDifficulty(&g_Simulation, 1);
             }
             else if (key == GLFW_KEY_3)
             {
-                g_DifficultyLevel = 2;
-                g_DifficultyChosen = true;
-                g_GameStartTime = glfwGetTime();
+                Simulation_ChooseDifficulty(&g_Simulation, 2);
             }
+
+            if (g_Simulation.difficulty_chosen && g_ReplayRecordFilename != NULL)
+                Replay_RecordDifficulty(&g_Replay, g_Simulation);
         }
     }
 
@@ -1817,6 +2175,21 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mod)
                 g_CameraLookAt = !g_CameraLookAt;
     }
 
+    // F8: habilita o profiling ou, se já estiver habilitado, salva os
+    // escopos coletados até agora (veja "profiler.h").
+    if (key == GLFW_KEY_F8 && action == GLFW_PRESS)
+    {
+        if (!g_ProfilerEnabled)
+        {
+            Profiler_SetEnabled(true);
+            printf("Profiling habilitado. Pressione F8 novamente para salvar \"%s\".\n", g_ProfileOutputFilename);
+        }
+        else
+        {
+            Profiler_WriteChromeTrace(g_ProfileOutputFilename);
+        }
+    }
+
     if (key == GLFW_KEY_SPACE)
     {
         if (action == GLFW_PRESS)
@@ -1882,12 +2255,9 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mod)
         glfwSetWindowShouldClose(window, GL_TRUE);
 
     // Se o usuário apertar a tecla R, recarregamos os shaders dos arquivos "shader_fragment.glsl" e "shader_vertex.glsl".
+    // Veja RequestShaderReload().
     if (key == GLFW_KEY_R && action == GLFW_PRESS)
-    {
-        LoadShadersFromFiles();
-        fprintf(stdout,"Shaders recarregados!\n");
-        fflush(stdout);
-    }
+        RequestShaderReload();
 }
 
 // Definimos o callback para impressão de erros da GLFW no terminal
@@ -1995,6 +2365,46 @@ void TextRendering_ShowFramesPerSecond(GLFWwindow* window)
     TextRendering_PrintString(window, buffer, 1.0f-(numchars + 1)*charwidth, 1.0f-lineheight, 1.0f);
 }
 
+// Escrevemos na tela o número de instâncias visíveis e descartadas pelo
+// frustum culling no quadro atual, logo abaixo dos quadros por segundo.
+void TextRendering_ShowCullingStats(GLFWwindow* window)
+{
+    if ( !g_ShowInfoText )
+        return;
+
+    char buffer[64];
+    int numchars = snprintf(buffer, 64, "%d visible, %d culled", (int)g_VisibleInstances, (int)g_CulledInstances);
+
+    float lineheight = TextRendering_LineHeight(window);
+    float charwidth = TextRendering_CharWidth(window);
+
+    TextRendering_PrintString(window, buffer, 1.0f-(numchars + 1)*charwidth, 1.0f-2*lineheight, 1.0f);
+}
+
+// Escrevemos na tela o tempo de GPU de cada passe (veja "gputimer.h"), um por
+// linha, abaixo das estatísticas de culling.
+void TextRendering_ShowGpuTimes(GLFWwindow* window)
+{
+    if ( !g_ShowInfoText )
+        return;
+
+    float lineheight = TextRendering_LineHeight(window);
+    float charwidth = TextRendering_CharWidth(window);
+
+    float total = 0.0f;
+    for (int pass = 0; pass < GPU_NUM_PASSES; ++pass)
+    {
+        char buffer[64];
+        int numchars = snprintf(buffer, 64, "GPU %s: %.3f ms", GpuTimer_PassName(pass), GpuTimer_Milliseconds(pass));
+        TextRendering_PrintString(window, buffer, 1.0f-(numchars + 1)*charwidth, 1.0f-(3 + pass)*lineheight, 1.0f);
+        total += GpuTimer_Milliseconds(pass);
+    }
+
+    char buffer[64];
+    int numchars = snprintf(buffer, 64, "GPU total: %.3f ms", total);
+    TextRendering_PrintString(window, buffer, 1.0f-(numchars + 1)*charwidth, 1.0f-(3 + GPU_NUM_PASSES)*lineheight, 1.0f);
+}
+
 // Função para debugging: imprime no terminal todas informações de um modelo
 // geométrico carregado de um arquivo ".obj".
 // Veja: https://github.com/syoyo/tinyobjloader/blob/22883def8db9ef1f3ffb9b404318e7dd25fdbb51/loader_example.cc#L98
@@ -0,0 +1,878 @@
+#include "mesh.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+#include <glm/vec4.hpp>
+#include <glm/geometric.hpp>
+
+// Este construtor lê o modelo de um arquivo utilizando a biblioteca tinyobjloader.
+// Veja: https://github.com/syoyo/tinyobjloader
+ObjModel::ObjModel(const char* filename, const char* basepath, bool triangulate)
+{
+    printf("Carregando objetos do arquivo \"%s\"...\n", filename);
+
+    // Se basepath == NULL, então setamos basepath como o dirname do
+    // filename, para que os arquivos MTL sejam corretamente carregados caso
+    // estejam no mesmo diretório dos arquivos OBJ.
+    std::string fullpath(filename);
+    std::string dirname;
+    if (basepath == NULL)
+    {
+        auto i = fullpath.find_last_of("/");
+        if (i != std::string::npos)
+        {
+            dirname = fullpath.substr(0, i+1);
+            basepath = dirname.c_str();
+        }
+    }
+
+    std::string warn;
+    std::string err;
+    bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filename, basepath, triangulate);
+
+    if (!err.empty())
+        fprintf(stderr, "\n%s\n", err.c_str());
+
+    if (!ret)
+        throw std::runtime_error("Erro ao carregar modelo.");
+
+    for (size_t shape = 0; shape < shapes.size(); ++shape)
+    {
+        if (shapes[shape].name.empty())
+        {
+            fprintf(stderr,
+                    "*********************************************\n"
+                    "Erro: Objeto sem nome dentro do arquivo '%s'.\n"
+                    "Veja https://www.inf.ufrgs.br/~eslgastal/fcg-faq-etc.html#Modelos-3D-no-formato-OBJ .\n"
+                    "*********************************************\n",
+                filename);
+            throw std::runtime_error("Objeto sem nome.");
+        }
+        printf("- Objeto '%s'\n", shapes[shape].name.c_str());
+    }
+
+    printf("OK.\n");
+}
+
+// Função que escala o modelo do plano e suas coordenadas de textura de acordo
+// com o parâmetro scale
+void ScalePlaneModelAndTexCoords(ObjModel* model, float scale)
+{
+    for (auto& vertex : model->attrib.vertices) {
+        vertex *= scale;
+    }
+
+    for (auto& texcoord : model->attrib.texcoords) {
+        texcoord *= scale;
+    }
+}
+
+// Função que computa as normais de um ObjModel, caso elas não tenham sido
+// especificadas dentro do arquivo ".obj"
+void ComputeNormals(ObjModel* model)
+{
+    if ( !model->attrib.normals.empty() )
+        return;
+
+    // Primeiro computamos as normais para todos os TRIÂNGULOS.
+    // Segundo, computamos as normais dos VÉRTICES através do método proposto
+    // por Gouraud, onde a normal de cada vértice vai ser a média das normais de
+    // todas as faces que compartilham este vértice.
+
+    size_t num_vertices = model->attrib.vertices.size() / 3;
+
+    std::vector<int> num_triangles_per_vertex(num_vertices, 0);
+    std::vector<glm::vec4> vertex_normals(num_vertices, glm::vec4(0.0f,0.0f,0.0f,0.0f));
+
+    for (size_t shape = 0; shape < model->shapes.size(); ++shape)
+    {
+        size_t num_triangles = model->shapes[shape].mesh.num_face_vertices.size();
+
+        for (size_t triangle = 0; triangle < num_triangles; ++triangle)
+        {
+            assert(model->shapes[shape].mesh.num_face_vertices[triangle] == 3);
+
+            glm::vec3  vertices[3];
+            for (size_t vertex = 0; vertex < 3; ++vertex)
+            {
+                tinyobj::index_t idx = model->shapes[shape].mesh.indices[3*triangle + vertex];
+                const float vx = model->attrib.vertices[3*idx.vertex_index + 0];
+                const float vy = model->attrib.vertices[3*idx.vertex_index + 1];
+                const float vz = model->attrib.vertices[3*idx.vertex_index + 2];
+                vertices[vertex] = glm::vec3(vx,vy,vz);
+            }
+
+            const glm::vec3  a = vertices[0];
+            const glm::vec3  b = vertices[1];
+            const glm::vec3  c = vertices[2];
+
+            const glm::vec4  n = glm::vec4(glm::cross(b-a,c-a), 0.0f);
+
+            for (size_t vertex = 0; vertex < 3; ++vertex)
+            {
+                tinyobj::index_t idx = model->shapes[shape].mesh.indices[3*triangle + vertex];
+                num_triangles_per_vertex[idx.vertex_index] += 1;
+                vertex_normals[idx.vertex_index] += n;
+                model->shapes[shape].mesh.indices[3*triangle + vertex].normal_index = idx.vertex_index;
+            }
+        }
+    }
+
+    model->attrib.normals.resize( 3*num_vertices );
+
+    for (size_t i = 0; i < vertex_normals.size(); ++i)
+    {
+        glm::vec4 n = vertex_normals[i] / (float)num_triangles_per_vertex[i];
+        n /= glm::length(glm::vec3(n));
+        model->attrib.normals[3*i + 0] = n.x;
+        model->attrib.normals[3*i + 1] = n.y;
+        model->attrib.normals[3*i + 2] = n.z;
+    }
+}
+
+// Chave que identifica um vértice único da malha: a combinação de índices de
+// posição, normal e coordenada de textura de um canto de triângulo do OBJ.
+struct VertexKey
+{
+    int vertex_index;
+    int normal_index;
+    int texcoord_index;
+
+    bool operator==(const VertexKey& other) const
+    {
+        return vertex_index == other.vertex_index
+            && normal_index == other.normal_index
+            && texcoord_index == other.texcoord_index;
+    }
+};
+
+struct VertexKeyHash
+{
+    size_t operator()(const VertexKey& key) const
+    {
+        // Combinação simples dos três índices (constantes de hashing espacial
+        // de Teschner et al.), suficiente para índices de arquivos OBJ.
+        return (size_t)((uint32_t)key.vertex_index * 73856093u
+                      ^ (uint32_t)key.normal_index * 19349663u
+                      ^ (uint32_t)key.texcoord_index * 83492791u);
+    }
+};
+
+// Otimização da ordem dos triângulos para a cache de vértices pós-transformação
+// da GPU, utilizando o algoritmo de Tom Forsyth ("Linear-Speed Vertex Cache
+// Optimisation", 2006). Cada vértice recebe uma pontuação que depende da sua
+// posição em uma cache LRU simulada e do número de triângulos ainda não
+// emitidos que o utilizam; a cada passo emitimos o triângulo de maior
+// pontuação entre os que tocam a cache.
+static const int   FORSYTH_CACHE_SIZE          = 32;
+static const float FORSYTH_CACHE_DECAY_POWER   = 1.5f;
+static const float FORSYTH_LAST_TRI_SCORE      = 0.75f;
+static const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+static const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+static float ForsythVertexScore(int cache_position, int remaining_valence)
+{
+    if ( remaining_valence == 0 )
+        return -1.0f; // Vértice não é mais utilizado por nenhum triângulo
+
+    float score = 0.0f;
+    if ( cache_position >= 0 )
+    {
+        if ( cache_position < 3 )
+        {
+            // Vértices do último triângulo emitido recebem uma pontuação fixa,
+            // para não favorecer "fitas" de triângulos longas e estreitas.
+            score = FORSYTH_LAST_TRI_SCORE;
+        }
+        else
+        {
+            const float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+            score = 1.0f - (cache_position - 3) * scaler;
+            score = powf(score, FORSYTH_CACHE_DECAY_POWER);
+        }
+    }
+
+    // Vértices com poucos triângulos restantes são priorizados, para que
+    // sejam "terminados" e saiam da cache.
+    score += FORSYTH_VALENCE_BOOST_SCALE * powf((float)remaining_valence, -FORSYTH_VALENCE_BOOST_POWER);
+    return score;
+}
+
+// Reordena os triângulos de indices[first, first+count) in-place.
+static void OptimizeVertexCache(uint32_t* indices, size_t count, size_t num_vertices)
+{
+    const size_t num_triangles = count / 3;
+    if ( num_triangles < 2 )
+        return;
+
+    // Lista de adjacência vértice -> triângulos (vetores compactos por offset)
+    std::vector<int>      valence(num_vertices, 0);
+    for (size_t i = 0; i < count; ++i)
+        valence[indices[i]] += 1;
+
+    std::vector<uint32_t> adjacency_offset(num_vertices + 1, 0);
+    for (size_t v = 0; v < num_vertices; ++v)
+        adjacency_offset[v+1] = adjacency_offset[v] + valence[v];
+
+    std::vector<uint32_t> adjacency(count);
+    std::vector<uint32_t> adjacency_fill(adjacency_offset.begin(), adjacency_offset.end() - 1);
+    for (size_t t = 0; t < num_triangles; ++t)
+        for (size_t k = 0; k < 3; ++k)
+            adjacency[adjacency_fill[indices[3*t + k]]++] = (uint32_t)t;
+
+    std::vector<float> vertex_score(num_vertices);
+    for (size_t v = 0; v < num_vertices; ++v)
+        vertex_score[v] = ForsythVertexScore(-1, valence[v]);
+
+    std::vector<bool>  triangle_emitted(num_triangles, false);
+
+    std::vector<uint32_t> output;
+    output.reserve(count);
+
+    // Cache LRU simulada; +3 entradas para os vértices recém inseridos antes
+    // de descartarmos os mais antigos.
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> new_cache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    new_cache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+    size_t scan_cursor = 0; // Para buscar um triângulo novo quando a cache não ajuda
+    int best_triangle = -1;
+
+    for (size_t emitted = 0; emitted < num_triangles; ++emitted)
+    {
+        if ( best_triangle < 0 )
+        {
+            // Nenhum triângulo adjacente à cache: pegamos o primeiro ainda
+            // não emitido (a busca é linear no total, pois o cursor só avança).
+            while ( triangle_emitted[scan_cursor] )
+                ++scan_cursor;
+            best_triangle = (int)scan_cursor;
+        }
+
+        const uint32_t* tri = &indices[3*best_triangle];
+        triangle_emitted[best_triangle] = true;
+        output.push_back(tri[0]);
+        output.push_back(tri[1]);
+        output.push_back(tri[2]);
+
+        // Remove o triângulo da lista de adjacência dos seus vértices
+        for (size_t k = 0; k < 3; ++k)
+        {
+            uint32_t v = tri[k];
+            uint32_t* begin = &adjacency[adjacency_offset[v]];
+            uint32_t* end   = begin + valence[v];
+            uint32_t* found = std::find(begin, end, (uint32_t)best_triangle);
+            *found = *(end - 1);
+            valence[v] -= 1;
+        }
+
+        // Atualiza a cache: vértices do triângulo vão para o início
+        new_cache.clear();
+        new_cache.push_back(tri[0]);
+        new_cache.push_back(tri[1]);
+        new_cache.push_back(tri[2]);
+        for (size_t i = 0; i < cache.size(); ++i)
+        {
+            uint32_t v = cache[i];
+            if ( v != tri[0] && v != tri[1] && v != tri[2] )
+                new_cache.push_back(v);
+        }
+
+        // Vértices que saíram da cache perdem a pontuação de posição
+        for (size_t i = FORSYTH_CACHE_SIZE; i < new_cache.size(); ++i)
+        {
+            uint32_t v = new_cache[i];
+            vertex_score[v] = ForsythVertexScore(-1, valence[v]);
+        }
+        if ( new_cache.size() > (size_t)FORSYTH_CACHE_SIZE )
+            new_cache.resize(FORSYTH_CACHE_SIZE);
+        cache.swap(new_cache);
+
+        // Recalcula pontuações dos vértices na cache e escolhe o próximo
+        // triângulo entre os que tocam algum deles.
+        for (size_t i = 0; i < cache.size(); ++i)
+        {
+            uint32_t v = cache[i];
+            vertex_score[v] = ForsythVertexScore((int)i, valence[v]);
+        }
+
+        best_triangle = -1;
+        float best_score = -1.0f;
+        for (size_t i = 0; i < cache.size(); ++i)
+        {
+            uint32_t v = cache[i];
+            for (int a = 0; a < valence[v]; ++a)
+            {
+                uint32_t t = adjacency[adjacency_offset[v] + a];
+                float score = vertex_score[indices[3*t+0]]
+                            + vertex_score[indices[3*t+1]]
+                            + vertex_score[indices[3*t+2]];
+                if ( score > best_score )
+                {
+                    best_score = score;
+                    best_triangle = (int)t;
+                }
+            }
+        }
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+// Converte um float para half-float (IEEE 754 binary16), arredondando para o
+// mais próximo. Valores fora do intervalo viram infinito; NaN é preservado.
+static uint16_t FloatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign     = (bits >> 16) & 0x8000u;
+    int32_t  exponent = (int32_t)((bits >> 23) & 0xFFu) - 127 + 15;
+    uint32_t mantissa = bits & 0x007FFFFFu;
+
+    if ( ((bits >> 23) & 0xFFu) == 0xFFu ) // Infinito ou NaN
+        return (uint16_t)(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+
+    if ( exponent >= 31 ) // Grande demais: infinito
+        return (uint16_t)(sign | 0x7C00u);
+
+    if ( exponent <= 0 )
+    {
+        // Número subnormal em half (ou zero)
+        if ( exponent < -10 )
+            return (uint16_t)sign;
+        mantissa |= 0x00800000u;
+        uint32_t shift = (uint32_t)(14 - exponent);
+        uint32_t half_mantissa = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1u);
+        uint32_t halfway = 1u << (shift - 1);
+        if ( remainder > halfway || (remainder == halfway && (half_mantissa & 1u)) )
+            half_mantissa += 1;
+        return (uint16_t)(sign | half_mantissa);
+    }
+
+    uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1FFFu;
+    if ( remainder > 0x1000u || (remainder == 0x1000u && (half & 1u)) )
+        half += 1; // Pode propagar para o expoente, o que é o resultado correto
+    return (uint16_t)half;
+}
+
+// Quantiza x, dentro do intervalo [lo, hi], para um inteiro unorm16.
+static uint16_t QuantizeUnorm16(float x, float lo, float hi)
+{
+    float extent = hi - lo;
+    if ( !(extent > 0.0f) )
+        return 0;
+    float t = (x - lo) / extent;
+    t = std::min(std::max(t, 0.0f), 1.0f);
+    return (uint16_t)(t * 65535.0f + 0.5f);
+}
+
+static int16_t QuantizeSnorm16(float x)
+{
+    x = std::min(std::max(x, -1.0f), 1.0f);
+    return (int16_t)(x >= 0.0f ? x * 32767.0f + 0.5f : x * 32767.0f - 0.5f);
+}
+
+// Codificação octaédrica de uma normal unitária (Meyer et al., "On Floating-Point
+// Normal Vectors", 2010): a esfera é projetada no octaedro |x|+|y|+|z| = 1 e o
+// hemisfério inferior é "dobrado" sobre o quadrado [-1,1]^2. Normais inválidas
+// (NaN, geradas por triângulos degenerados) viram (0,0,1).
+static void EncodeOctahedralNormal(float nx, float ny, float nz, int16_t out[2])
+{
+    float l1 = std::fabs(nx) + std::fabs(ny) + std::fabs(nz);
+    if ( !(l1 > 0.0f) || !std::isfinite(l1) )
+    {
+        out[0] = 0;
+        out[1] = 0;
+        return;
+    }
+
+    float u = nx / l1;
+    float v = ny / l1;
+    if ( nz < 0.0f )
+    {
+        float fu = (1.0f - std::fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+        float fv = (1.0f - std::fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+        u = fu;
+        v = fv;
+    }
+
+    out[0] = QuantizeSnorm16(u);
+    out[1] = QuantizeSnorm16(v);
+}
+
+// Constrói triângulos para futura renderização a partir de um ObjModel. Esta é
+// a parte de BuildTrianglesAndAddToVirtualScene() que roda somente na CPU.
+//
+// Cantos de triângulos de um mesmo objeto com a mesma combinação de índices
+// (posição, normal, textura) são fundidos em um único vértice, e cada objeto
+// tem seus triângulos reordenados por OptimizeVertexCache(). Por fim os
+// vértices são renumerados na ordem em que são utilizados pelo buffer de
+// índices, para que a leitura dos atributos pela GPU seja o mais sequencial
+// possível, e convertidos para o formato PackedVertex.
+void BuildMeshData(ObjModel* model, MeshData* mesh)
+{
+    std::vector<uint32_t>&     indices  = mesh->indices;
+    std::vector<PackedVertex>& vertices = mesh->vertices;
+
+    indices.clear();
+    vertices.clear();
+    mesh->shapes.clear();
+
+    std::vector<VertexKey> unique_keys;
+    std::unordered_map<VertexKey, uint32_t, VertexKeyHash> unique_vertices;
+
+    for (size_t shape = 0; shape < model->shapes.size(); ++shape)
+    {
+        size_t first_index = indices.size();
+        size_t first_vertex = unique_keys.size(); // Primeiro vértice único desta shape
+        size_t num_triangles = model->shapes[shape].mesh.num_face_vertices.size();
+
+        // Vértices não são compartilhados entre shapes (veja MeshData)
+        unique_vertices.clear();
+
+        const float minval = std::numeric_limits<float>::min();
+        const float maxval = std::numeric_limits<float>::max();
+
+        glm::vec3 bbox_min = glm::vec3(maxval,maxval,maxval);
+        glm::vec3 bbox_max = glm::vec3(minval,minval,minval);
+
+        for (size_t triangle = 0; triangle < num_triangles; ++triangle)
+        {
+            assert(model->shapes[shape].mesh.num_face_vertices[triangle] == 3);
+
+            for (size_t vertex = 0; vertex < 3; ++vertex)
+            {
+                tinyobj::index_t idx = model->shapes[shape].mesh.indices[3*triangle + vertex];
+
+                VertexKey key = { idx.vertex_index, idx.normal_index, idx.texcoord_index };
+                auto inserted = unique_vertices.insert(std::make_pair(key, (uint32_t)unique_keys.size()));
+                if ( inserted.second )
+                    unique_keys.push_back(key);
+
+                indices.push_back(inserted.first->second);
+
+                const float vx = model->attrib.vertices[3*idx.vertex_index + 0];
+                const float vy = model->attrib.vertices[3*idx.vertex_index + 1];
+                const float vz = model->attrib.vertices[3*idx.vertex_index + 2];
+
+                bbox_min.x = std::min(bbox_min.x, vx);
+                bbox_min.y = std::min(bbox_min.y, vy);
+                bbox_min.z = std::min(bbox_min.z, vz);
+                bbox_max.x = std::max(bbox_max.x, vx);
+                bbox_max.y = std::max(bbox_max.y, vy);
+                bbox_max.z = std::max(bbox_max.z, vz);
+            }
+        }
+
+        // Uma shape pode não ter triângulos (ex.: um grupo somente com
+        // elementos "l" ou "p"), e então num_indices é zero.
+        size_t num_indices = indices.size() - first_index;
+
+        MeshShape theshape;
+        theshape.name        = model->shapes[shape].name;
+        theshape.first_index = first_index; // Primeiro índice
+        theshape.num_indices = num_indices; // Número de indices
+        theshape.bbox_min    = bbox_min;
+        theshape.bbox_max    = bbox_max;
+
+        mesh->shapes.push_back(theshape);
+
+        if ( num_indices == 0 )
+            continue;
+
+        // Os vértices desta shape são [first_vertex, unique_keys.size());
+        // OptimizeVertexCache() recebe os índices relativos a first_vertex,
+        // para que as suas tabelas por vértice tenham somente o tamanho da
+        // shape, e não de todas as shapes anteriores.
+        for (size_t i = first_index; i < first_index + num_indices; ++i)
+            indices[i] -= (uint32_t)first_vertex;
+        OptimizeVertexCache(&indices[first_index], num_indices, unique_keys.size() - first_vertex);
+        for (size_t i = first_index; i < first_index + num_indices; ++i)
+            indices[i] += (uint32_t)first_vertex;
+    }
+
+    // Renumera os vértices na ordem de primeiro uso e gera os atributos
+    const uint32_t unused = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> remap(unique_keys.size(), unused);
+    vertices.reserve(unique_keys.size());
+
+    for (size_t shape = 0; shape < mesh->shapes.size(); ++shape)
+    {
+        const MeshShape& theshape = mesh->shapes[shape];
+        const glm::vec3& lo = theshape.bbox_min;
+        const glm::vec3& hi = theshape.bbox_max;
+
+        for (size_t i = theshape.first_index; i < theshape.first_index + theshape.num_indices; ++i)
+        {
+            uint32_t& index = indices[i];
+            if ( remap[index] == unused )
+            {
+                remap[index] = (uint32_t)vertices.size();
+
+                const VertexKey& idx = unique_keys[index];
+                PackedVertex packed;
+                memset(&packed, 0, sizeof(packed));
+
+                const float* p = &model->attrib.vertices[3*idx.vertex_index];
+                packed.position[0] = QuantizeUnorm16(p[0], lo.x, hi.x);
+                packed.position[1] = QuantizeUnorm16(p[1], lo.y, hi.y);
+                packed.position[2] = QuantizeUnorm16(p[2], lo.z, hi.z);
+
+                // Inspecionando o código da tinyobjloader, o aluno Bernardo
+                // Sulzbach (2017/1) apontou que a maneira correta de testar se
+                // existem normais e coordenadas de textura no ObjModel é
+                // comparando se o índice retornado é -1. Fazemos isso abaixo.
+
+                if ( idx.normal_index != -1 )
+                {
+                    const float* n = &model->attrib.normals[3*idx.normal_index];
+                    EncodeOctahedralNormal(n[0], n[1], n[2], packed.normal);
+                }
+
+                if ( idx.texcoord_index != -1 )
+                {
+                    packed.texcoord[0] = FloatToHalf(model->attrib.texcoords[2*idx.texcoord_index + 0]);
+                    packed.texcoord[1] = FloatToHalf(model->attrib.texcoords[2*idx.texcoord_index + 1]);
+                }
+
+                vertices.push_back(packed);
+            }
+            index = remap[index];
+        }
+    }
+}
+
+// ============================================================================
+// Cache binário de malhas
+// ============================================================================
+//
+// Layout do arquivo ".meshcache" (little-endian, mesma arquitetura que o gerou):
+//
+//   MeshCacheHeader
+//   para cada shape: uint32 tamanho do nome, nome, uint32 first_index,
+//                    uint32 num_indices, float bbox_min[3], float bbox_max[3]
+//   PackedVertex vertices[num_vertices]
+//   uint32   indices[num_indices]
+//
+// Os vetores já estão no layout final enviado para a GPU, então a leitura do
+// cache é apenas uma cópia a partir do arquivo mapeado em memória.
+
+// Incremente sempre que o layout do arquivo ou de MeshData mudar.
+static const uint32_t MESH_CACHE_VERSION = 3;
+static const char     MESH_CACHE_MAGIC[8] = "FCGMESH";
+
+struct MeshCacheHeader
+{
+    char     magic[8];
+    uint32_t version;
+    float    scale;        // Escala aplicada por ScalePlaneModelAndTexCoords()
+    uint64_t source_size;  // Tamanho do arquivo ".obj" de origem
+    int64_t  source_mtime; // Data de modificação do arquivo ".obj" de origem
+    uint32_t num_shapes;
+    uint32_t num_vertices;
+    uint32_t num_indices;
+};
+
+static std::string MeshCacheFilename(const char* obj_filename)
+{
+    return std::string(obj_filename) + ".meshcache";
+}
+
+// Obtém tamanho e data de modificação do arquivo ".obj" de origem.
+static bool GetSourceFileStamp(const char* filename, uint64_t* size, int64_t* mtime)
+{
+    struct stat st;
+    if ( stat(filename, &st) != 0 )
+        return false;
+
+    *size  = (uint64_t)st.st_size;
+    *mtime = (int64_t)st.st_mtime;
+    return true;
+}
+
+// Arquivo aberto somente para leitura e mapeado em memória.
+struct MappedFile
+{
+    const unsigned char* data;
+    size_t               size;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int    fd;
+#endif
+
+    explicit MappedFile(const char* filename)
+        : data(NULL), size(0)
+    {
+    #ifdef _WIN32
+        mapping = NULL;
+        file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if ( file == INVALID_HANDLE_VALUE )
+            return;
+
+        LARGE_INTEGER file_size;
+        if ( !GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0 )
+            return;
+
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if ( mapping == NULL )
+            return;
+
+        data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if ( data != NULL )
+            size = (size_t)file_size.QuadPart;
+    #else
+        fd = open(filename, O_RDONLY);
+        if ( fd < 0 )
+            return;
+
+        struct stat st;
+        if ( fstat(fd, &st) != 0 || st.st_size == 0 )
+            return;
+
+        void* ptr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if ( ptr == MAP_FAILED )
+            return;
+
+        data = (const unsigned char*)ptr;
+        size = (size_t)st.st_size;
+    #endif
+    }
+
+    ~MappedFile()
+    {
+    #ifdef _WIN32
+        if ( data != NULL )
+            UnmapViewOfFile(data);
+        if ( mapping != NULL )
+            CloseHandle(mapping);
+        if ( file != INVALID_HANDLE_VALUE )
+            CloseHandle(file);
+    #else
+        if ( data != NULL )
+            munmap((void*)data, size);
+        if ( fd >= 0 )
+            close(fd);
+    #endif
+    }
+};
+
+// Leitura sequencial, com verificação de limites, de um arquivo mapeado.
+struct MeshCacheReader
+{
+    const unsigned char* cursor;
+    const unsigned char* end;
+
+    bool Read(void* dst, size_t num_bytes)
+    {
+        if ( (size_t)(end - cursor) < num_bytes )
+            return false;
+        if ( num_bytes > 0 )
+            memcpy(dst, cursor, num_bytes);
+        cursor += num_bytes;
+        return true;
+    }
+
+    template <typename T>
+    bool ReadVector(std::vector<T>* v, size_t count)
+    {
+        if ( (size_t)(end - cursor) / sizeof(T) < count )
+            return false;
+        v->resize(count);
+        return Read(v->data(), count * sizeof(T));
+    }
+};
+
+bool MeshCache_Load(const char* obj_filename, float scale, MeshData* mesh)
+{
+    uint64_t source_size;
+    int64_t  source_mtime;
+    if ( !GetSourceFileStamp(obj_filename, &source_size, &source_mtime) )
+        return false;
+
+    std::string cache_filename = MeshCacheFilename(obj_filename);
+    MappedFile file(cache_filename.c_str());
+    if ( file.data == NULL )
+        return false;
+
+    MeshCacheReader reader = { file.data, file.data + file.size };
+
+    MeshCacheHeader header;
+    if ( !reader.Read(&header, sizeof(header)) )
+        return false;
+
+    if ( memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) != 0
+      || header.version != MESH_CACHE_VERSION
+      || header.scale != scale
+      || header.source_size != source_size
+      || header.source_mtime != source_mtime )
+    {
+        return false;
+    }
+
+    // Um cache truncado ou corrompido pode conter contagens absurdas; antes
+    // de alocar qualquer coisa, verificamos se o arquivo tem ao menos o
+    // tamanho que elas exigem (cada shape ocupa no mínimo o comprimento do
+    // nome, first_index, num_indices e a bounding box).
+    const uint64_t min_shape_size = sizeof(uint32_t) * 3 + sizeof(float) * 6;
+    uint64_t min_payload_size = (uint64_t)header.num_shapes   * min_shape_size
+                              + (uint64_t)header.num_vertices * sizeof(PackedVertex)
+                              + (uint64_t)header.num_indices  * sizeof(uint32_t);
+    if ( min_payload_size > (uint64_t)(reader.end - reader.cursor) )
+        return false;
+
+    MeshData loaded;
+    loaded.shapes.resize(header.num_shapes);
+    for (size_t i = 0; i < loaded.shapes.size(); ++i)
+    {
+        MeshShape& shape = loaded.shapes[i];
+
+        uint32_t name_length;
+        if ( !reader.Read(&name_length, sizeof(name_length)) )
+            return false;
+        if ( (size_t)(reader.end - reader.cursor) < name_length )
+            return false;
+        shape.name.assign((const char*)reader.cursor, name_length);
+        reader.cursor += name_length;
+
+        uint32_t first_index, num_indices;
+        float    bbox[6];
+        if ( !reader.Read(&first_index, sizeof(first_index))
+          || !reader.Read(&num_indices, sizeof(num_indices))
+          || !reader.Read(bbox, sizeof(bbox)) )
+        {
+            return false;
+        }
+        shape.first_index = first_index;
+        shape.num_indices = num_indices;
+        shape.bbox_min    = glm::vec3(bbox[0], bbox[1], bbox[2]);
+        shape.bbox_max    = glm::vec3(bbox[3], bbox[4], bbox[5]);
+    }
+
+    if ( !reader.ReadVector(&loaded.vertices, header.num_vertices)
+      || !reader.ReadVector(&loaded.indices, header.num_indices) )
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < loaded.shapes.size(); ++i)
+    {
+        if ( loaded.shapes[i].first_index + loaded.shapes[i].num_indices > loaded.indices.size() )
+            return false;
+    }
+    for (size_t i = 0; i < loaded.indices.size(); ++i)
+    {
+        if ( loaded.indices[i] >= loaded.vertices.size() )
+            return false;
+    }
+
+    std::swap(*mesh, loaded);
+
+    printf("Carregando objetos do cache \"%s\"... OK (%d objetos).\n",
+           cache_filename.c_str(), (int)mesh->shapes.size());
+    return true;
+}
+
+bool MeshCache_Save(const char* obj_filename, float scale, const MeshData& mesh)
+{
+    MeshCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+    header.version = MESH_CACHE_VERSION;
+    header.scale   = scale;
+    if ( !GetSourceFileStamp(obj_filename, &header.source_size, &header.source_mtime) )
+        return false;
+    header.num_shapes               = (uint32_t)mesh.shapes.size();
+    header.num_vertices             = (uint32_t)mesh.vertices.size();
+    header.num_indices              = (uint32_t)mesh.indices.size();
+
+    // Escrevemos primeiro em um arquivo temporário e depois o renomeamos,
+    // para que uma execução interrompida nunca deixe um cache pela metade.
+    std::string cache_filename = MeshCacheFilename(obj_filename);
+    std::string temp_filename  = cache_filename + ".tmp";
+
+    FILE* file = fopen(temp_filename.c_str(), "wb");
+    if ( file == NULL )
+    {
+        fprintf(stderr, "WARNING: Cannot write mesh cache \"%s\".\n", cache_filename.c_str());
+        return false;
+    }
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    for (size_t i = 0; ok && i < mesh.shapes.size(); ++i)
+    {
+        const MeshShape& shape = mesh.shapes[i];
+        uint32_t name_length = (uint32_t)shape.name.size();
+        uint32_t first_index = (uint32_t)shape.first_index;
+        uint32_t num_indices = (uint32_t)shape.num_indices;
+        float    bbox[6] = { shape.bbox_min.x, shape.bbox_min.y, shape.bbox_min.z,
+                             shape.bbox_max.x, shape.bbox_max.y, shape.bbox_max.z };
+
+        ok = fwrite(&name_length, sizeof(name_length), 1, file) == 1
+          && fwrite(shape.name.data(), 1, name_length, file) == name_length
+          && fwrite(&first_index, sizeof(first_index), 1, file) == 1
+          && fwrite(&num_indices, sizeof(num_indices), 1, file) == 1
+          && fwrite(bbox, sizeof(bbox), 1, file) == 1;
+    }
+
+    ok = ok
+      && fwrite(mesh.vertices.data(), sizeof(PackedVertex), mesh.vertices.size(), file) == mesh.vertices.size()
+      && fwrite(mesh.indices.data(), sizeof(uint32_t), mesh.indices.size(), file) == mesh.indices.size();
+
+    ok = (fclose(file) == 0) && ok;
+
+    if ( ok )
+    {
+        // No Windows, rename() falha se o destino já existir.
+        remove(cache_filename.c_str());
+        ok = rename(temp_filename.c_str(), cache_filename.c_str()) == 0;
+    }
+
+    if ( !ok )
+    {
+        remove(temp_filename.c_str());
+        fprintf(stderr, "WARNING: Cannot write mesh cache \"%s\".\n", cache_filename.c_str());
+    }
+
+    return ok;
+}
+
+void LoadMeshData(const char* filename, MeshData* mesh, float scale)
+{
+    if ( MeshCache_Load(filename, scale, mesh) )
+        return;
+
+    ObjModel model(filename);
+    if ( scale != 1.0f )
+        ScalePlaneModelAndTexCoords(&model, scale);
+    ComputeNormals(&model);
+    BuildMeshData(&model, mesh);
+
+    MeshCache_Save(filename, scale, *mesh);
+}
@@ -0,0 +1,130 @@
+#include "profiler.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+std::atomic<bool> g_ProfilerEnabled(false);
+
+static std::vector<ProfileEvent>             g_ProfileEvents;
+static std::atomic<uint64_t>                 g_ProfileNextEvent(0);
+static std::atomic<uint32_t>                 g_ProfileNextThread(0);
+static std::chrono::steady_clock::time_point g_ProfileEpoch = std::chrono::steady_clock::now();
+
+// Identificador da thread atual, atribuído na primeira vez que ela registra
+// um escopo (a thread principal recebe 0 em Profiler_Init()).
+static uint32_t CurrentThread()
+{
+    static thread_local uint32_t thread = g_ProfileNextThread.fetch_add(1);
+    return thread;
+}
+
+void Profiler_Init()
+{
+    CurrentThread();
+    g_ProfileEpoch = std::chrono::steady_clock::now();
+    g_ProfileEvents.assign(PROFILER_MAX_EVENTS, ProfileEvent());
+    g_ProfileNextEvent = 0;
+}
+
+void Profiler_SetEnabled(bool enabled)
+{
+    g_ProfilerEnabled = enabled && !g_ProfileEvents.empty();
+}
+
+double Profiler_Now()
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - g_ProfileEpoch).count();
+}
+
+static void RecordEvent(const char* name, const char* detail, double start, double end, uint32_t thread)
+{
+    // Cada thread reserva a sua posição no buffer com uma única operação
+    // atômica; as mais antigas são sobrescritas quando o buffer enche.
+    uint64_t index = g_ProfileNextEvent.fetch_add(1, std::memory_order_relaxed);
+    ProfileEvent& event = g_ProfileEvents[index & (PROFILER_MAX_EVENTS - 1)];
+
+    event.name = name;
+    event.detail[0] = '\0';
+    if ( detail != NULL )
+    {
+        strncpy(event.detail, detail, sizeof(event.detail) - 1);
+        event.detail[sizeof(event.detail) - 1] = '\0';
+    }
+    event.start    = start;
+    event.duration = end - start;
+    event.thread   = thread;
+}
+
+void Profiler_Record(const char* name, const char* detail, double start, double end)
+{
+    RecordEvent(name, detail, start, end, CurrentThread());
+}
+
+void Profiler_RecordGPU(const char* name, double start, double end)
+{
+    RecordEvent(name, NULL, start, end, PROFILER_GPU_THREAD);
+}
+
+static std::string EscapeJSON(const char* text)
+{
+    std::string escaped;
+    for (const char* c = text; *c != '\0'; ++c)
+    {
+        if ( *c == '"' || *c == '\\' )
+            escaped += '\\';
+        if ( (unsigned char)*c >= 0x20 )
+            escaped += *c;
+    }
+    return escaped;
+}
+
+bool Profiler_WriteChromeTrace(const char* filename)
+{
+    FILE* file = fopen(filename, "w");
+    if ( file == NULL )
+    {
+        fprintf(stderr, "ERROR: Cannot write profiling trace \"%s\".\n", filename);
+        return false;
+    }
+
+    uint64_t end   = g_ProfileNextEvent.load();
+    uint64_t begin = end > PROFILER_MAX_EVENTS ? end - PROFILER_MAX_EVENTS : 0;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    // Nomes das threads
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"GPU\"}}",
+            PROFILER_GPU_THREAD);
+    uint32_t num_threads = g_ProfileNextThread.load();
+    for (uint32_t t = 0; t < num_threads; ++t)
+    {
+        if ( t == 0 )
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"main\"}}");
+        else
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"worker %u\"}}", t, t);
+    }
+
+    for (uint64_t i = begin; i < end; ++i)
+    {
+        const ProfileEvent& event = g_ProfileEvents[i & (PROFILER_MAX_EVENTS - 1)];
+        fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u",
+                EscapeJSON(event.name).c_str(), event.thread == PROFILER_GPU_THREAD ? "gpu" : "cpu",
+                event.start, event.duration, event.thread);
+        if ( event.detail[0] != '\0' )
+            fprintf(file, ",\"args\":{\"detail\":\"%s\"}", EscapeJSON(event.detail).c_str());
+        fprintf(file, "}");
+    }
+
+    fprintf(file, "\n]}\n");
+
+    if ( fclose(file) != 0 )
+    {
+        fprintf(stderr, "ERROR: Cannot write profiling trace \"%s\".\n", filename);
+        return false;
+    }
+
+    printf("Profiling: %d escopos salvos em \"%s\".\n", (int)(end - begin), filename);
+    return true;
+}
@@ -0,0 +1,237 @@
+#include "programcache.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <GLFW/glfw3.h>
+
+#include "profiler.h"
+
+// Funções e constantes do OpenGL 4.1 / GL_ARB_get_program_binary
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+typedef void (APIENTRYP PFN_GetProgramBinary)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFN_ProgramBinary)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFN_ProgramParameteri)(GLuint program, GLenum pname, GLint value);
+
+static PFN_GetProgramBinary  g_GetProgramBinary  = NULL;
+static PFN_ProgramBinary     g_ProgramBinary     = NULL;
+static PFN_ProgramParameteri g_ProgramParameteri = NULL;
+
+// Identifica o driver atual; faz parte da chave de cada programa
+static std::string g_ProgramCacheDriver;
+
+static const char     PROGRAM_CACHE_MAGIC[8]   = { 'F','C','G','P','R','O','G','\0' };
+static const uint32_t PROGRAM_CACHE_VERSION    = 1;
+static const char*    PROGRAM_CACHE_DIRECTORY  = "../data/shaders/";
+
+// Cabeçalho de um arquivo ".programcache", seguido por "binary_length"
+// bytes retornados por glGetProgramBinary().
+struct ProgramCacheHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t binary_format;
+    uint64_t key;           // Veja ProgramCacheKey()
+    uint32_t binary_length;
+    uint32_t padding;
+};
+
+void ProgramCache_Init()
+{
+    g_GetProgramBinary  = NULL;
+    g_ProgramBinary     = NULL;
+    g_ProgramParameteri = NULL;
+
+    bool core_41 = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 1);
+    if ( !core_41 && !glfwExtensionSupported("GL_ARB_get_program_binary") )
+        return;
+
+    // Alguns drivers suportam a extensão mas não oferecem nenhum formato
+    // binário (por exemplo, com o cache de shaders do próprio driver desligado).
+    GLint num_formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+    if ( num_formats <= 0 )
+        return;
+
+    g_GetProgramBinary  = (PFN_GetProgramBinary)glfwGetProcAddress("glGetProgramBinary");
+    g_ProgramBinary     = (PFN_ProgramBinary)glfwGetProcAddress("glProgramBinary");
+    g_ProgramParameteri = (PFN_ProgramParameteri)glfwGetProcAddress("glProgramParameteri");
+
+    if ( g_GetProgramBinary == NULL || g_ProgramBinary == NULL || g_ProgramParameteri == NULL )
+    {
+        g_GetProgramBinary  = NULL;
+        g_ProgramBinary     = NULL;
+        g_ProgramParameteri = NULL;
+        return;
+    }
+
+    g_ProgramCacheDriver.clear();
+    const GLenum strings[3] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    for (int i = 0; i < 3; ++i)
+    {
+        const GLubyte* value = glGetString(strings[i]);
+        if ( value != NULL )
+            g_ProgramCacheDriver += (const char*)value;
+        g_ProgramCacheDriver += '\n';
+    }
+}
+
+void ProgramCache_PrepareLink(GLuint program_id)
+{
+    if ( g_ProgramParameteri != NULL )
+        g_ProgramParameteri(program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+// FNV-1a de 64 bits
+static void HashBytes(uint64_t* hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; ++i)
+    {
+        *hash ^= bytes[i];
+        *hash *= 1099511628211ull;
+    }
+}
+
+// Chave de um programa: o código dos dois shaders e o driver atual. Os
+// tamanhos separam as strings, para que o mesmo texto dividido de outra
+// forma entre os shaders gere outra chave.
+static uint64_t ProgramCacheKey(const std::string& vertex_source, const std::string& fragment_source)
+{
+    uint64_t hash = 14695981039346656037ull;
+    const std::string* parts[3] = { &vertex_source, &fragment_source, &g_ProgramCacheDriver };
+    for (int i = 0; i < 3; ++i)
+    {
+        uint64_t length = parts[i]->size();
+        HashBytes(&hash, &length, sizeof(length));
+        HashBytes(&hash, parts[i]->data(), parts[i]->size());
+    }
+    return hash;
+}
+
+static std::string ProgramCacheFilename(const char* name)
+{
+    return std::string(PROGRAM_CACHE_DIRECTORY) + name + ".programcache";
+}
+
+GLuint ProgramCache_Load(const char* name, const std::string& vertex_source, const std::string& fragment_source)
+{
+    if ( g_ProgramBinary == NULL )
+        return 0;
+
+    PROFILE_SCOPE_DETAIL("ProgramCache_Load", name);
+
+    std::string filename = ProgramCacheFilename(name);
+    FILE* file = fopen(filename.c_str(), "rb");
+    if ( file == NULL )
+        return 0;
+
+    ProgramCacheHeader header;
+    std::vector<unsigned char> binary;
+
+    bool ok = fread(&header, sizeof(header), 1, file) == 1
+           && memcmp(header.magic, PROGRAM_CACHE_MAGIC, sizeof(header.magic)) == 0
+           && header.version == PROGRAM_CACHE_VERSION
+           && header.key == ProgramCacheKey(vertex_source, fragment_source)
+           && header.binary_length > 0;
+
+    if ( ok )
+    {
+        binary.resize(header.binary_length);
+        ok = fread(binary.data(), 1, binary.size(), file) == binary.size();
+    }
+
+    fclose(file);
+
+    if ( !ok )
+        return 0;
+
+    // O driver pode recusar um binário mesmo com a chave correta (por
+    // exemplo, após uma atualização que não mudou GL_VERSION); nesse caso o
+    // programa simplesmente não fica linkado.
+    GLuint program_id = glCreateProgram();
+    g_ProgramBinary(program_id, header.binary_format, binary.data(), (GLsizei)binary.size());
+
+    GLint linked_ok = GL_FALSE;
+    glGetProgramiv(program_id, GL_LINK_STATUS, &linked_ok);
+    if ( linked_ok == GL_FALSE )
+    {
+        glDeleteProgram(program_id);
+        return 0;
+    }
+
+    return program_id;
+}
+
+bool ProgramCache_Save(const char* name, GLuint program_id, const std::string& vertex_source, const std::string& fragment_source)
+{
+    if ( g_GetProgramBinary == NULL )
+        return false;
+
+    GLint linked_ok = GL_FALSE;
+    glGetProgramiv(program_id, GL_LINK_STATUS, &linked_ok);
+    if ( linked_ok == GL_FALSE )
+        return false;
+
+    GLint binary_length = 0;
+    glGetProgramiv(program_id, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+    if ( binary_length <= 0 )
+        return false;
+
+    std::vector<unsigned char> binary(binary_length);
+    GLenum  binary_format = 0;
+    GLsizei written = 0;
+    g_GetProgramBinary(program_id, binary_length, &written, &binary_format, binary.data());
+    if ( written <= 0 )
+        return false;
+
+    ProgramCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PROGRAM_CACHE_MAGIC, sizeof(header.magic));
+    header.version       = PROGRAM_CACHE_VERSION;
+    header.binary_format = binary_format;
+    header.key           = ProgramCacheKey(vertex_source, fragment_source);
+    header.binary_length = (uint32_t)written;
+
+    // Assim como em MeshCache_Save(), escrevemos primeiro em um arquivo
+    // temporário, para nunca deixar um cache pela metade.
+    std::string filename      = ProgramCacheFilename(name);
+    std::string temp_filename = filename + ".tmp";
+
+    FILE* file = fopen(temp_filename.c_str(), "wb");
+    if ( file == NULL )
+    {
+        fprintf(stderr, "WARNING: Cannot write program cache \"%s\".\n", filename.c_str());
+        return false;
+    }
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+           && fwrite(binary.data(), 1, (size_t)written, file) == (size_t)written;
+    ok = (fclose(file) == 0) && ok;
+
+    if ( ok )
+    {
+        // No Windows, rename() falha se o destino já existir.
+        remove(filename.c_str());
+        ok = rename(temp_filename.c_str(), filename.c_str()) == 0;
+    }
+
+    if ( !ok )
+    {
+        remove(temp_filename.c_str());
+        fprintf(stderr, "WARNING: Cannot write program cache \"%s\".\n", filename.c_str());
+    }
+
+    return ok;
+}
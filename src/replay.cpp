@@ -0,0 +1,215 @@
+#include "replay.h"
+
+#include <cstdio>
+#include <cstring>
+
+// Formato do arquivo de replay (little-endian):
+//
+//   ReplayHeader
+//   num_runs x { uint32 length; uint8 input; }
+//
+// onde cada trecho repete as teclas "input" por "length" passos.
+
+// Incremente sempre que o formato do arquivo mudar.
+static const uint32_t REPLAY_VERSION = 1;
+static const char     REPLAY_MAGIC[8] = "FCGRPLY";
+
+struct ReplayHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t simulation_hz;    // Deve ser igual a SIMULATION_HZ
+    int32_t  difficulty_level;
+    uint32_t num_runs;
+    uint64_t difficulty_tick;
+    uint64_t num_ticks;
+    uint64_t final_checksum;
+};
+
+void Replay_Init(Replay* replay)
+{
+    replay->difficulty_level = -1;
+    replay->difficulty_tick  = 0;
+    replay->inputs.clear();
+    replay->final_checksum   = 0;
+}
+
+void Replay_RecordStep(Replay* replay, const SimulationState& state, SimulationInput input)
+{
+    // Passos executados antes do início da gravação não tinham teclas
+    if ( replay->inputs.size() < state.tick )
+        replay->inputs.resize(state.tick, 0);
+    replay->inputs.push_back(input);
+}
+
+void Replay_RecordDifficulty(Replay* replay, const SimulationState& state)
+{
+    replay->difficulty_level = state.difficulty_level;
+    replay->difficulty_tick  = state.tick;
+}
+
+SimulationInput Replay_InputForStep(const Replay& replay, SimulationState* state)
+{
+    if ( replay.difficulty_level >= 0 && !state->difficulty_chosen
+      && state->tick == replay.difficulty_tick )
+    {
+        Simulation_ChooseDifficulty(state, replay.difficulty_level);
+    }
+
+    return state->tick < replay.inputs.size() ? replay.inputs[state->tick] : 0;
+}
+
+bool Replay_Finished(const Replay& replay, const SimulationState& state)
+{
+    return state.tick >= replay.inputs.size();
+}
+
+// FNV-1a de 64 bits
+static void HashBytes(uint64_t* hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; ++i)
+    {
+        *hash ^= bytes[i];
+        *hash *= 1099511628211ull;
+    }
+}
+
+uint64_t Replay_Checksum(const SimulationState& state)
+{
+    uint64_t hash = 14695981039346656037ull;
+    HashBytes(&hash, &state.car_pos, sizeof(state.car_pos));
+    HashBytes(&hash, &state.car_yaw, sizeof(state.car_yaw));
+    HashBytes(&hash, &state.car_speed, sizeof(state.car_speed));
+    HashBytes(&hash, &state.car_pos_pc, sizeof(state.car_pos_pc));
+    HashBytes(&hash, &state.car_yaw_pc, sizeof(state.car_yaw_pc));
+    HashBytes(&hash, &state.car_speed_pc, sizeof(state.car_speed_pc));
+    HashBytes(&hash, &state.tick, sizeof(state.tick));
+    return hash;
+}
+
+bool Replay_Load(const char* filename, Replay* replay)
+{
+    FILE* file = fopen(filename, "rb");
+    if ( file == NULL )
+    {
+        fprintf(stderr, "ERROR: Cannot open replay file \"%s\".\n", filename);
+        return false;
+    }
+
+    ReplayHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1
+           && memcmp(header.magic, REPLAY_MAGIC, sizeof(header.magic)) == 0
+           && header.version == REPLAY_VERSION;
+
+    if ( ok && header.simulation_hz != SIMULATION_HZ )
+    {
+        fprintf(stderr, "ERROR: Replay \"%s\" was recorded at %u Hz, but the simulation runs at %d Hz.\n",
+                filename, header.simulation_hz, SIMULATION_HZ);
+        fclose(file);
+        return false;
+    }
+
+    // Um replay truncado ou corrompido pode conter contagens absurdas; antes
+    // de reservar memória, verificamos se o arquivo tem todos os trechos e se
+    // eles bastam para num_ticks passos.
+    if ( ok )
+    {
+        long header_end = ftell(file);
+        ok = header_end >= 0 && fseek(file, 0, SEEK_END) == 0;
+        long file_end = ok ? ftell(file) : -1;
+        ok = ok && file_end >= header_end && fseek(file, header_end, SEEK_SET) == 0;
+
+        const uint64_t run_size = sizeof(uint32_t) + sizeof(SimulationInput);
+        ok = ok && (uint64_t)header.num_runs * run_size <= (uint64_t)(file_end - header_end)
+                && header.num_ticks <= (uint64_t)header.num_runs * UINT32_MAX;
+    }
+
+    Replay loaded;
+    Replay_Init(&loaded);
+    if ( ok )
+    {
+        loaded.difficulty_level = header.difficulty_level;
+        loaded.difficulty_tick  = header.difficulty_tick;
+        loaded.final_checksum   = header.final_checksum;
+        loaded.inputs.reserve(header.num_ticks);
+    }
+
+    for (uint32_t i = 0; ok && i < header.num_runs; ++i)
+    {
+        uint32_t        length;
+        SimulationInput input;
+        ok = fread(&length, sizeof(length), 1, file) == 1
+          && fread(&input, sizeof(input), 1, file) == 1
+          && loaded.inputs.size() + length <= header.num_ticks;
+        if ( ok )
+            loaded.inputs.insert(loaded.inputs.end(), length, input);
+    }
+
+    ok = ok && loaded.inputs.size() == header.num_ticks;
+    fclose(file);
+
+    if ( !ok )
+    {
+        fprintf(stderr, "ERROR: Invalid replay file \"%s\".\n", filename);
+        return false;
+    }
+
+    std::swap(*replay, loaded);
+
+    printf("Carregando replay \"%s\"... OK (%llu passos).\n",
+           filename, (unsigned long long)replay->inputs.size());
+    return true;
+}
+
+bool Replay_Save(const char* filename, const Replay& replay)
+{
+    // Run-length encoding das teclas
+    std::vector<uint32_t>        lengths;
+    std::vector<SimulationInput> run_inputs;
+    for (size_t i = 0; i < replay.inputs.size(); ++i)
+    {
+        if ( run_inputs.empty() || run_inputs.back() != replay.inputs[i] || lengths.back() == UINT32_MAX )
+        {
+            lengths.push_back(0);
+            run_inputs.push_back(replay.inputs[i]);
+        }
+        lengths.back() += 1;
+    }
+
+    ReplayHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, REPLAY_MAGIC, sizeof(header.magic));
+    header.version          = REPLAY_VERSION;
+    header.simulation_hz    = SIMULATION_HZ;
+    header.difficulty_level = replay.difficulty_level;
+    header.num_runs         = (uint32_t)lengths.size();
+    header.difficulty_tick  = replay.difficulty_tick;
+    header.num_ticks        = replay.inputs.size();
+    header.final_checksum   = replay.final_checksum;
+
+    FILE* file = fopen(filename, "wb");
+    if ( file == NULL )
+    {
+        fprintf(stderr, "ERROR: Cannot write replay file \"%s\".\n", filename);
+        return false;
+    }
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (size_t i = 0; ok && i < lengths.size(); ++i)
+    {
+        ok = fwrite(&lengths[i], sizeof(lengths[i]), 1, file) == 1
+          && fwrite(&run_inputs[i], sizeof(run_inputs[i]), 1, file) == 1;
+    }
+    ok = (fclose(file) == 0) && ok;
+
+    if ( !ok )
+    {
+        fprintf(stderr, "ERROR: Cannot write replay file \"%s\".\n", filename);
+        return false;
+    }
+
+    printf("Replay gravado em \"%s\" (%llu passos, %d trechos).\n",
+           filename, (unsigned long long)replay.inputs.size(), (int)lengths.size());
+    return true;
+}
@@ -0,0 +1,341 @@
+#include "simulation.h"
+
+#include <cmath>
+
+#include "profiler.h"
+
+// Parâmetros de movimento do carro do jogador
+static const float GRAVITY            = -9.8f; // Aceleração da gravidade (em unidades/s^2)
+static const float CAR_MAX_SPEED      = 25.0f; // Velocidade máxima
+static const float CAR_ACCELERATION   = 5.0f;  // Aceleração
+static const float CAR_DECELERATION   = 5.0f;  // Desaceleração (freio)
+static const float CAR_ROTATION_SPEED = 1.0f;  // Velocidade de rotação (guinada)
+
+// Tamanho das células das grades de broadphase dos obstáculos. Um pouco maior
+// que o carro, para que ele ocupe poucas células por consulta.
+static const float COLLIDER_CELL_SIZE = 8.0f;
+
+std::vector<glm::vec3> Simulation_WallPositions()
+{
+    std::vector<glm::vec3> wall_positions = {
+        {  -6.0f, 0.0f, 405.0f},
+        {  -4.0f, 0.0f, 405.0f},
+        {  -2.0f, 0.0f, 405.0f},
+        {   0.0f, 0.0f, 405.0f},
+        {   2.0f, 0.0f, 405.0f},
+        {   4.0f, 0.0f, 405.0f},
+        {   6.0f, 0.0f, 405.0f}
+    };
+    return wall_positions;
+}
+
+std::vector<glm::vec3> Simulation_GuardRailPositions()
+{
+    std::vector<glm::vec3> guardRail_positions;
+
+    // Inicializa a sequência de posições ao longo do eixo X e Z
+    float z_increment = 5.0f; // Incremento do eixo Z
+    float x_values[] = {-5.0f, 5.0f}; // Valores de X alternando entre -5.0f e 5.0f
+
+    // Gerar posições com alternância de X
+    for (int i = 0; i < 2; ++i) {  // i = 0 -> X = -5.0f, i = 1 -> X = 5.0f
+        float x = x_values[i];  // Definir valor de X para a iteração
+
+        // Gerar as posições ao longo do eixo Z
+        for (float z = -320.0f; z <= 400.0f; z += z_increment) {
+            // Adiciona a posição no vetor guardRail_positions
+            guardRail_positions.push_back(glm::vec3(x, 0.8f, z));
+        }
+    }
+
+    return guardRail_positions;
+}
+
+void Simulation_BuildTrack(TrackColliders* track, const BoundingBoxLookup& lookup, const glm::vec3& plane_position)
+{
+    glm::vec3 bbox_min, bbox_max;
+
+    lookup("the_track", &bbox_min, &bbox_max);
+    track->plane_size     = bbox_max.x - bbox_min.x;
+    track->plane_position = plane_position;
+
+    // Altura dos carros na largada, para que a parte inferior do carro fique
+    // na mesma altura que o plano.
+    lookup("tc-car_surface.jpg", &bbox_min, &bbox_max);
+    track->car_height = bbox_max.y - bbox_min.y;
+    lookup("tc-car_surface_pc.jpg", &bbox_min, &bbox_max);
+    track->car_height_pc = bbox_max.y - bbox_min.y;
+
+    lookup("the_car", &track->car_bbox_min, &track->car_bbox_max);
+    lookup("the_car_pc", &track->car_pc_bbox_min, &track->car_pc_bbox_max);
+
+    track->wall_positions = Simulation_WallPositions();
+    lookup("the_wall", &track->wall_bbox_min, &track->wall_bbox_max);
+
+    track->guardRail_positions = Simulation_GuardRailPositions();
+    lookup("the_guardRail", &track->guardRail_bbox_min, &track->guardRail_bbox_max);
+
+    BuildStaticColliderGrid(&track->wall_grid, track->wall_positions,
+                            track->wall_bbox_min, track->wall_bbox_max,
+                            glm::vec3(WALL_SCALE), COLLIDER_CELL_SIZE);
+    BuildStaticColliderGrid(&track->guardRail_grid, track->guardRail_positions,
+                            track->guardRail_bbox_min, track->guardRail_bbox_max,
+                            glm::vec3(GUARDRAIL_SCALE), COLLIDER_CELL_SIZE);
+}
+
+void Simulation_Init(SimulationState* state, const TrackColliders& track)
+{
+    // A posição Y do carro deve ser a altura do plano mais a altura do
+    // modelo do carro, para que a base do carro coincida com o plano.
+    state->car_pos      = glm::vec4( 1.0f, 0.0f + track.car_height, -328.6f, 10.0f);
+    state->car_velocity = glm::vec3(0.0f, 0.0f, 0.0f);
+    state->car_yaw      = 0.0f;
+    state->car_speed    = 0.0f;
+
+    state->car_pos_pc   = glm::vec4(-1.0f, 0.0f + track.car_height_pc, -328.6f, 0.0f);
+    state->car_yaw_pc   = 0.0f;
+    state->car_speed_pc = 0.0f;
+
+    state->difficulty_level  = 1;
+    state->difficulty_chosen = false;
+    state->race_started      = false;
+    state->race_time         = 0.0;
+    state->tick              = 0;
+}
+
+void Simulation_ChooseDifficulty(SimulationState* state, int level)
+{
+    state->difficulty_level  = level;
+    state->difficulty_chosen = true;
+    state->race_time         = 0.0;
+}
+
+int Simulation_Winner(const SimulationState& state)
+{
+    if (state.car_pos.z >= RACE_FINISH_Z)
+        return RACE_WINNER_PLAYER;
+    else if (state.car_pos_pc.z >= RACE_FINISH_Z)
+        return RACE_WINNER_PC;
+    return RACE_WINNER_NONE;
+}
+
+void Simulation_Step(SimulationState* state, SimulationInput input, const TrackColliders& track, float deltaTime)
+{
+    PROFILE_SCOPE("Simulation_Step");
+
+    state->tick += 1;
+
+    // Relógio da corrida: conta o tempo simulado desde a escolha da dificuldade
+    if (state->difficulty_chosen)
+        state->race_time += deltaTime;
+
+    // Aplica gravidade na velocidade vertical
+    state->car_velocity.y += GRAVITY * deltaTime;
+
+    // Atualiza a posição do carro com base na velocidade
+    state->car_pos.y += state->car_velocity.y * deltaTime;
+
+    // ===============================================
+    // Teste de Colisão (Ponto para AABB)
+    // ===============================================
+    CheckCarbyBounds(state->car_pos, track.plane_size);
+
+    // ===============================================
+    // Colisão com o plano
+    // ===============================================
+    const glm::vec3& bbox_min_car = track.car_bbox_min;
+    const glm::vec3& bbox_max_car = track.car_bbox_max;
+
+    ResolveCarGroundCollision(state->car_pos, bbox_min_car, track.plane_position.y);
+    ResolveCarGroundCollision(state->car_pos_pc, track.car_pc_bbox_min, track.plane_position.y);
+
+    // Posição no início do passo, origem da varredura contínua contra os
+    // obstáculos (veja abaixo)
+    glm::vec4 stepStartCarPos = state->car_pos;
+
+    // ===============================================
+    // Lógica de Movimento do Carro
+    // ===============================================
+    float elapsed = state->difficulty_chosen ? (float)state->race_time : 0.0f;
+    if (elapsed >= RACE_COUNTDOWN)
+    {
+        PROFILE_SCOPE("Movimento dos carros");
+
+        state->race_started = true;
+
+        // Aceleração/Desaceleração
+        if (input & SIMULATION_KEY_W) {
+            state->car_speed += CAR_ACCELERATION * deltaTime;
+        } else if (input & SIMULATION_KEY_S) {
+            state->car_speed -= CAR_DECELERATION * deltaTime;
+        } else {
+            // Aplica atrito/desaceleração natural quando nenhuma tecla de movimento está pressionada
+            if (state->car_speed > 0) {
+                state->car_speed -= CAR_DECELERATION * deltaTime;
+                if (state->car_speed < 0) state->car_speed = 0;
+            } else if (state->car_speed < 0) {
+                state->car_speed += CAR_DECELERATION * deltaTime;
+                if (state->car_speed > 0) state->car_speed = 0;
+            }
+        }
+
+        // Limita a velocidade máxima
+        state->car_speed = glm::clamp(state->car_speed, -CAR_MAX_SPEED, CAR_MAX_SPEED);
+
+        // Rotação (guinada)
+        if ((input & SIMULATION_KEY_A) && state->car_speed != 0.0f) { // Só vira se estiver em movimento
+            state->car_yaw += CAR_ROTATION_SPEED * deltaTime * (state->car_speed > 0 ? 1.0f : -1.0f); // Inverte a rotação se estiver dando ré
+        }
+        if ((input & SIMULATION_KEY_D) && state->car_speed != 0.0f) { // Só vira se estiver em movimento
+            state->car_yaw -= CAR_ROTATION_SPEED * deltaTime * (state->car_speed > 0 ? 1.0f : -1.0f); // Inverte a rotação se estiver dando ré
+        }
+
+        // Atualiza a posição do carro com base na velocidade e direção
+        glm::vec3 direction_vector = glm::vec3(sin(state->car_yaw), 0.0f, cos(state->car_yaw));
+        state->car_pos.x += direction_vector.x * state->car_speed * deltaTime;
+        state->car_pos.z += direction_vector.z * state->car_speed * deltaTime;
+
+        // ==================================================================
+        // Lógica bem simples do Movimento do Carro do player 2 - IA (car_pc)
+        // ==================================================================
+        float max_speed_pc;    // velocidade máxima da IA
+        float acceleration_pc; // aceleração IA
+
+        switch (state->difficulty_level)
+        {
+            case 0: // Fácil
+                max_speed_pc = 15.0f;
+                acceleration_pc = 3.0f;
+                break;
+            case 1: // Médio
+                max_speed_pc = 25.0f;
+                acceleration_pc = 4.5f;
+                break;
+            case 2: // Difícil
+                max_speed_pc = 50.0f;
+                acceleration_pc = 9.5f;
+                break;
+            default: // Medio
+                max_speed_pc = 25.0f;
+                acceleration_pc = 4.0f;
+                break;
+        }
+
+        if (state->car_pos_pc.z < RACE_FINISH_Z)
+        {
+            PROFILE_SCOPE("IA");
+
+            // Aumenta a velocidade até o máximo
+            state->car_speed_pc += acceleration_pc * deltaTime;
+            state->car_speed_pc = glm::min(state->car_speed_pc, max_speed_pc);
+
+            // Atualiza posição da IA (sempre para frente, sem rotação)
+            glm::vec3 dir_pc = glm::vec3(sin(state->car_yaw_pc), 0.0f, cos(state->car_yaw_pc));
+            state->car_pos_pc.x += dir_pc.x * state->car_speed_pc * deltaTime;
+            state->car_pos_pc.z += dir_pc.z * state->car_speed_pc * deltaTime;
+        }
+        else
+        {
+            // Parou ao final da pista
+            state->car_speed_pc = 0.0f;
+        }
+    }
+
+    // ===============================================
+    // Colisão Esfera vs Esfera entre os dois carros
+    // ===============================================
+
+    // Raio estimado dos carros
+    float radius_player = 1.0f;
+    float radius_pc     = 1.0f;
+
+    ResolveSphereCollision(state->car_pos, radius_player, state->car_speed,
+                           state->car_pos_pc, radius_pc, state->car_speed_pc);
+
+    // ===============================================
+    // Colisão com obstáculos estáticos
+    // ===============================================
+    glm::vec3 direction = glm::vec3(sin(state->car_yaw), 0.0f, cos(state->car_yaw));
+    glm::vec3 move = direction * state->car_speed * deltaTime;
+    glm::vec4 tentativeCarPos = state->car_pos + glm::vec4(move, 0.0f);
+
+    bool hitWall = false;
+
+    // ===============================================
+    // Colisão contínua (swept AABB)
+    // ===============================================
+    // Feita antes dos testes discretos: se o carro atravessou ou entrou em
+    // um obstáculo durante o passo (passo longo, velocidade alta ou um
+    // obstáculo fino como os postes da chegada), a varredura desde o início
+    // do passo encontra o primeiro contato e o carro para ali, afastado da
+    // face atingida por uma pequena folga. Só pela posição final, a menor
+    // penetração de um obstáculo mais estreito que o carro pode ser para o
+    // lado, e o carro o contornaria em vez de parar.
+    {
+        PROFILE_SCOPE("Colisão contínua");
+        float toi = 1.0f, wall_toi;
+        glm::vec3 normal, wall_normal;
+        bool swept = false;
+        if (SweepCarStaticColliders(stepStartCarPos, tentativeCarPos, state->car_yaw, bbox_min_car, bbox_max_car,
+                                    track.wall_grid, &wall_toi, &wall_normal)) {
+            swept  = true;
+            toi    = wall_toi;
+            normal = wall_normal;
+        }
+        if (SweepCarStaticColliders(stepStartCarPos, tentativeCarPos, state->car_yaw, bbox_min_car, bbox_max_car,
+                                    track.guardRail_grid, &wall_toi, &wall_normal) &&
+            (!swept || wall_toi < toi)) {
+            swept  = true;
+            toi    = wall_toi;
+            normal = wall_normal;
+        }
+        if (swept) {
+            const float CONTACT_SKIN = 0.001f;
+            tentativeCarPos = stepStartCarPos + (tentativeCarPos - stepStartCarPos) * toi
+                            + glm::vec4(normal * CONTACT_SKIN, 0.0f);
+            hitWall = true;
+        }
+    }
+    // ===============================================
+    // Colisão com paredes visíveis
+    // ===============================================
+    // Penetrações que a varredura não vê (o carro já começou o passo
+    // encostado, ou girou para dentro de um obstáculo) são desfeitas
+    // empurrando o carro na horizontal. Também são feitas após a
+    // varredura, já que a posição de contato pode encostar em outro
+    // obstáculo que o carro já tocava.
+    {
+        PROFILE_SCOPE("Colisão com paredes");
+        hitWall = ResolveCarStaticCollision(
+            tentativeCarPos,
+            state->car_yaw,
+            bbox_min_car,
+            bbox_max_car,
+            state->car_speed,
+            track.wall_grid
+        ) || hitWall;
+    }
+    // ===============================================
+    // Colisão com os guard rails (cubo vs cubo)
+    // ===============================================
+    {
+        PROFILE_SCOPE("Colisão com guard rails");
+        hitWall = ResolveCarStaticCollision(
+            tentativeCarPos,
+            state->car_yaw,
+            bbox_min_car,
+            bbox_max_car,
+            state->car_speed,
+            track.guardRail_grid
+        ) || hitWall;
+    }
+    // ===============================================
+    // Aplicação do movimento e tratamento de colisão
+    // ===============================================
+    if (!hitWall) {
+        state->car_pos = tentativeCarPos; // Movimento aceito
+    } else {
+        state->car_pos = tentativeCarPos; // Aplicar posição corrigida com empurrão
+        state->car_speed = 0.0f;
+    }
+}
@@ -1,6 +1,9 @@
 // Based on http://hamelot.io/visualization/opengl-text-without-any-external-libraries/
 //   and on https://github.com/rougier/freetype-gl
+#include <algorithm>
+#include <cstring>
 #include <string>
+#include <vector>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -10,6 +13,7 @@
 
 #include "utils.h"
 #include "dejavufont.h"
+#include "programcache.h"
 
 GLuint CreateGpuProgram(GLuint vertex_shader_id, GLuint fragment_shader_id); // Função definida em main.cpp
 
@@ -87,8 +91,40 @@ GLuint textVBO;
 GLuint textprogram_id;
 GLuint texttexture_id;
 
+// Vértice de um glifo: posição na tela (NDC) e coordenadas de textura
+struct TextVertex
+{
+    float x, y, s, t;
+};
+
+// Todos os glifos escritos com TextRendering_PrintString() durante um quadro
+// são acumulados aqui e desenhados de uma só vez por TextRendering_Flush(),
+// com uma única chamada de desenho.
+std::vector<TextVertex> g_TextVertices;
+size_t                  g_TextVBOCapacity = 0; // Em vértices
+
+// VBO dos textos retidos (veja TextRendering_CreateLabel()). Cada label
+// ocupa um trecho fixo, reservado em ordem a partir do início.
+GLuint textLabelVAO;
+GLuint textLabelVBO;
+size_t g_TextLabelVBOCapacity = 0; // Em vértices
+size_t g_TextLabelVBOUsed = 0;
+
+// Glifo de cada caractere ASCII, ou NULL se a fonte não o possui. Evita a
+// busca linear em dejavufont.glyphs para cada caractere.
+texture_glyph_t* g_GlyphTable[128];
+
 void TextRendering_Init()
 {
+    for (size_t c = 0; c < 128; ++c)
+        g_GlyphTable[c] = NULL;
+    for (size_t j = 0; j < dejavufont.glyphs_count; ++j)
+    {
+        uint32_t codepoint = dejavufont.glyphs[j].codepoint;
+        if (codepoint < 128 && g_GlyphTable[codepoint] == NULL)
+            g_GlyphTable[codepoint] = &dejavufont.glyphs[j];
+    }
+
     GLuint sampler;
 
     glGenBuffers(1, &textVBO);
@@ -101,16 +137,22 @@ void TextRendering_Init()
     glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glCheckError();
 
-    GLuint textvertexshader_id = glCreateShader(GL_VERTEX_SHADER);
-    TextRendering_LoadShader(textvertexshader_source, textvertexshader_id);
-    glCheckError();
+    // Assim como os shaders da cena, o programa de texto é lido do cache de
+    // programas quando possível (veja "programcache.h").
+    textprogram_id = ProgramCache_Load("text", textvertexshader_source, textfragmentshader_source);
+    if ( textprogram_id == 0 )
+    {
+        GLuint textvertexshader_id = glCreateShader(GL_VERTEX_SHADER);
+        TextRendering_LoadShader(textvertexshader_source, textvertexshader_id);
+        glCheckError();
 
-    GLuint textfragmentshader_id = glCreateShader(GL_FRAGMENT_SHADER);
-    TextRendering_LoadShader(textfragmentshader_source, textfragmentshader_id);
-    glCheckError();
+        GLuint textfragmentshader_id = glCreateShader(GL_FRAGMENT_SHADER);
+        TextRendering_LoadShader(textfragmentshader_source, textfragmentshader_id);
+        glCheckError();
 
-    textprogram_id = CreateGpuProgram(textvertexshader_id, textfragmentshader_id);
-    glLinkProgram(textprogram_id);
+        textprogram_id = CreateGpuProgram(textvertexshader_id, textfragmentshader_id);
+        ProgramCache_Save("text", textprogram_id, textvertexshader_source, textfragmentshader_source);
+    }
     glCheckError();
 
     GLuint texttex_uniform;
@@ -126,9 +168,26 @@ void TextRendering_Init()
 
     glBindVertexArray(textVAO);
 
+    // Espaço inicial para 1024 glifos; o VBO cresce em TextRendering_Flush()
+    // se um quadro escrever mais do que isso.
+    g_TextVBOCapacity = 6 * 1024;
+    g_TextVertices.reserve(g_TextVBOCapacity);
+
     glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-    glBufferData(GL_ARRAY_BUFFER, 24 * sizeof(float), NULL, GL_DYNAMIC_DRAW);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
+    glBufferData(GL_ARRAY_BUFFER, g_TextVBOCapacity * sizeof(TextVertex), NULL, GL_STREAM_DRAW);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(TextVertex), 0);
+    glEnableVertexAttribArray(0);
+    glCheckError();
+
+    // VBO dos labels (veja TextRendering_CreateLabel()), com o mesmo formato
+    glGenVertexArrays(1, &textLabelVAO);
+    glGenBuffers(1, &textLabelVBO);
+    glBindVertexArray(textLabelVAO);
+
+    g_TextLabelVBOCapacity = 6 * 256;
+    glBindBuffer(GL_ARRAY_BUFFER, textLabelVBO);
+    glBufferData(GL_ARRAY_BUFFER, g_TextLabelVBOCapacity * sizeof(TextVertex), NULL, GL_DYNAMIC_DRAW);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(TextVertex), 0);
     glEnableVertexAttribArray(0);
     glCheckError();
 
@@ -144,6 +203,42 @@ void TextRendering_Init()
 
 float textscale = 1.5f;
 
+// Escreve em "data" os dois triângulos do glifo com a "caneta" na posição
+// (x, y) e retorna a posição da caneta para o próximo glifo.
+static float LayoutGlyph(const texture_glyph_t* glyph, float x, float y, float sx, float sy, TextVertex data[6])
+{
+    x += glyph->kerning[0].kerning;
+    float x0 = (float) (x + glyph->offset_x * sx);
+    float y0 = (float) (y + glyph->offset_y * sy);
+    float x1 = (float) (x0 + glyph->width * sx);
+    float y1 = (float) (y0 - glyph->height * sy);
+
+    float s0 = glyph->s0 - 0.5f/dejavufont.tex_width;
+    float t0 = glyph->t0 - 0.5f/dejavufont.tex_height;
+    float s1 = glyph->s1 - 0.5f/dejavufont.tex_width;
+    float t1 = glyph->t1 - 0.5f/dejavufont.tex_height;
+
+    TextVertex quad[6] = {
+        { x0, y0, s0, t0 },
+        { x0, y1, s0, t1 },
+        { x1, y1, s1, t1 },
+        { x0, y0, s0, t0 },
+        { x1, y1, s1, t1 },
+        { x1, y0, s1, t0 }
+    };
+    for (int v = 0; v < 6; ++v)
+        data[v] = quad[v];
+
+    return x + glyph->advance_x * sx;
+}
+
+static texture_glyph_t* FindGlyph(char character)
+{
+    unsigned char c = (unsigned char)character;
+    return c < 128 ? g_GlyphTable[c] : NULL;
+}
+
+// Acumula os glifos de "str" para o próximo TextRendering_Flush()
 void TextRendering_PrintString(GLFWwindow* window, const std::string &str, float x, float y, float scale = 1.0f)
 {
     scale *= textscale;
@@ -154,61 +249,278 @@ void TextRendering_PrintString(GLFWwindow* window, const std::string &str, float
 
     for (size_t i = 0; i < str.size(); i++)
     {
-        // Find the glyph for the character we are looking for
-        texture_glyph_t *glyph = 0;
-        for (size_t j = 0; j < dejavufont.glyphs_count; ++j)
-        {
-            if (dejavufont.glyphs[j].codepoint == (uint32_t)str[i])
-            {
-                glyph = &dejavufont.glyphs[j];
-                break;
-            }
-        }
+        texture_glyph_t *glyph = FindGlyph(str[i]);
         if (!glyph) {
             continue;
         }
-        x += glyph->kerning[0].kerning;
-        float x0 = (float) (x + glyph->offset_x * sx);
-        float y0 = (float) (y + glyph->offset_y * sy);
-        float x1 = (float) (x0 + glyph->width * sx);
-        float y1 = (float) (y0 - glyph->height * sy);
-
-        float s0 = glyph->s0 - 0.5f/dejavufont.tex_width;
-        float t0 = glyph->t0 - 0.5f/dejavufont.tex_height;
-        float s1 = glyph->s1 - 0.5f/dejavufont.tex_width;
-        float t1 = glyph->t1 - 0.5f/dejavufont.tex_height;
-
-        struct {float x, y, s, t;} data[6] = {
-            { x0, y0, s0, t0 },
-            { x0, y1, s0, t1 },
-            { x1, y1, s1, t1 },
-            { x0, y0, s0, t0 },
-            { x1, y1, s1, t1 },
-            { x1, y0, s1, t0 }
-        };
-
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        glDepthFunc(GL_ALWAYS);
+
+        TextVertex data[6];
+        x = LayoutGlyph(glyph, x, y, sx, sy, data);
+        g_TextVertices.insert(g_TextVertices.end(), data, data + 6);
+    }
+}
+
+// Textos retidos ("labels"): ao contrário de TextRendering_PrintString(),
+// os triângulos de um label são calculados uma única vez e ficam guardados em
+// um VBO próprio (textLabelVBO). Eles só são recalculados quando o texto muda
+// (e então somente a partir do primeiro caractere diferente) ou quando a
+// janela muda de tamanho. Desenhar um label que não mudou custa somente
+// adicionar o seu trecho do VBO à lista de desenho do quadro.
+typedef size_t TextLabel;
+
+struct TextLabelData
+{
+    std::string             text;
+    float                   x, y, scale;
+    int                     layout_width;  // Tamanho da janela utilizado no layout;
+    int                     layout_height; // 0 se o layout precisa ser refeito
+    std::vector<TextVertex> vertices;      // Cópia dos triângulos que estão no VBO
+    std::vector<float>      pen_x;         // Posição da caneta antes de cada caractere
+    std::vector<size_t>     first_vertex;  // Primeiro vértice de cada caractere
+    size_t                  gpu_first;     // Trecho reservado no VBO, em vértices
+    size_t                  gpu_capacity;
+    size_t                  dirty_begin;   // Vértices ainda não enviados ao VBO
+    size_t                  dirty_end;
+};
+
+std::vector<TextLabelData> g_TextLabels;
+std::vector<TextLabel>     g_TextLabelsToDraw; // Labels desenhados no quadro atual
+std::vector<GLint>         g_TextLabelFirsts;  // Argumentos de glMultiDrawArrays()
+std::vector<GLsizei>       g_TextLabelCounts;
+
+// Tamanho da janela no quadro atual, lido em TextRendering_BeginFrame()
+int g_TextWindowWidth = 0;
+int g_TextWindowHeight = 0;
+
+static void MarkDirty(TextLabelData& label, size_t begin, size_t end)
+{
+    if (begin >= end)
+        return;
+    if (label.dirty_begin >= label.dirty_end)
+    {
+        label.dirty_begin = begin;
+        label.dirty_end = end;
+    }
+    else
+    {
+        label.dirty_begin = std::min(label.dirty_begin, begin);
+        label.dirty_end = std::max(label.dirty_end, end);
+    }
+}
+
+// Refaz o layout do label a partir do caractere "from", reaproveitando os
+// triângulos dos caracteres anteriores, e marca para envio somente os
+// vértices que mudaram.
+static void LayoutLabel(TextLabelData& label, size_t from)
+{
+    float scale = label.scale * textscale;
+    float sx = scale / label.layout_width;
+    float sy = scale / label.layout_height;
+
+    size_t first_changed = label.first_vertex[from];
+    std::vector<TextVertex> old_tail(label.vertices.begin() + first_changed, label.vertices.end());
+
+    label.vertices.resize(first_changed);
+    label.pen_x.resize(label.text.size() + 1);
+    label.first_vertex.resize(label.text.size() + 1);
+
+    float x = label.pen_x[from];
+    for (size_t i = from; i < label.text.size(); ++i)
+    {
+        label.pen_x[i] = x;
+        label.first_vertex[i] = label.vertices.size();
+
+        texture_glyph_t* glyph = FindGlyph(label.text[i]);
+        if (!glyph)
+            continue;
+
+        TextVertex data[6];
+        x = LayoutGlyph(glyph, x, label.y, sx, sy, data);
+        label.vertices.insert(label.vertices.end(), data, data + 6);
+    }
+    label.pen_x[label.text.size()] = x;
+    label.first_vertex[label.text.size()] = label.vertices.size();
+
+    // Os vértices iguais aos anteriores no início e no fim do trecho
+    // refeito não precisam ser enviados novamente.
+    size_t new_count = label.vertices.size() - first_changed;
+    size_t begin = 0;
+    while (begin < new_count && begin < old_tail.size()
+        && memcmp(&label.vertices[first_changed + begin], &old_tail[begin], sizeof(TextVertex)) == 0)
+        ++begin;
+    size_t end = new_count;
+    if (new_count == old_tail.size())
+    {
+        while (end > begin
+            && memcmp(&label.vertices[first_changed + end - 1], &old_tail[end - 1], sizeof(TextVertex)) == 0)
+            --end;
+    }
+    MarkDirty(label, first_changed + begin, first_changed + end);
+}
+
+// Layout completo, para o tamanho atual da janela
+static void RebuildLabel(TextLabelData& label)
+{
+    label.layout_width = g_TextWindowWidth;
+    label.layout_height = g_TextWindowHeight;
+    label.vertices.clear();
+    label.pen_x.assign(1, label.x);
+    label.first_vertex.assign(1, 0);
+    LayoutLabel(label, 0);
+    MarkDirty(label, 0, label.vertices.size());
+}
+
+TextLabel TextRendering_CreateLabel(const std::string &str, float x, float y, float scale = 1.0f)
+{
+    TextLabelData label;
+    label.text = str;
+    label.x = x;
+    label.y = y;
+    label.scale = scale;
+    label.layout_width = 0;
+    label.layout_height = 0;
+    label.gpu_first = 0;
+    label.gpu_capacity = 0;
+    label.dirty_begin = 0;
+    label.dirty_end = 0;
+    g_TextLabels.push_back(label);
+    return g_TextLabels.size() - 1;
+}
+
+// Troca o texto de um label. Não faz nada se o texto é o mesmo.
+void TextRendering_SetLabelText(TextLabel handle, const std::string &str)
+{
+    TextLabelData& label = g_TextLabels[handle];
+    if (label.text == str)
+        return;
+
+    size_t common = 0;
+    while (common < str.size() && common < label.text.size() && str[common] == label.text[common])
+        ++common;
+
+    label.text = str;
+    if (label.layout_width != 0)
+        LayoutLabel(label, common);
+}
+
+// Lê o tamanho da janela utilizado pelos labels neste quadro. Deve ser
+// chamada antes de TextRendering_DrawLabel().
+void TextRendering_BeginFrame(GLFWwindow* window)
+{
+    glfwGetWindowSize(window, &g_TextWindowWidth, &g_TextWindowHeight);
+}
+
+// Desenha o label no próximo TextRendering_Flush()
+void TextRendering_DrawLabel(TextLabel handle)
+{
+    TextLabelData& label = g_TextLabels[handle];
+    if (label.layout_width != g_TextWindowWidth || label.layout_height != g_TextWindowHeight)
+        RebuildLabel(label);
+
+    // Reservamos um novo trecho do VBO se o texto cresceu além do atual. O
+    // trecho antigo é abandonado: os labels são poucos e mudam pouco.
+    if (label.vertices.size() > label.gpu_capacity)
+    {
+        label.gpu_capacity = std::max(label.vertices.size() * 2, (size_t)6 * 16);
+        label.gpu_first = g_TextLabelVBOUsed;
+        g_TextLabelVBOUsed += label.gpu_capacity;
+        MarkDirty(label, 0, label.vertices.size());
+    }
+
+    if (!label.vertices.empty())
+        g_TextLabelsToDraw.push_back(handle);
+}
+
+// Envia ao VBO os vértices dos labels que mudaram
+static void UploadLabels()
+{
+    glBindBuffer(GL_ARRAY_BUFFER, textLabelVBO);
+
+    if (g_TextLabelVBOUsed > g_TextLabelVBOCapacity)
+    {
+        // O VBO é realocado; todos os labels são reenviados quando forem desenhados.
+        g_TextLabelVBOCapacity = std::max(g_TextLabelVBOUsed, 2 * g_TextLabelVBOCapacity);
+        glBufferData(GL_ARRAY_BUFFER, g_TextLabelVBOCapacity * sizeof(TextVertex), NULL, GL_DYNAMIC_DRAW);
+        for (size_t i = 0; i < g_TextLabels.size(); ++i)
+            MarkDirty(g_TextLabels[i], 0, g_TextLabels[i].vertices.size());
+    }
+
+    g_TextLabelFirsts.clear();
+    g_TextLabelCounts.clear();
+    for (size_t i = 0; i < g_TextLabelsToDraw.size(); ++i)
+    {
+        TextLabelData& label = g_TextLabels[g_TextLabelsToDraw[i]];
+        label.dirty_end = std::min(label.dirty_end, label.vertices.size());
+        if (label.dirty_begin < label.dirty_end)
+        {
+            glBufferSubData(GL_ARRAY_BUFFER,
+                            (label.gpu_first + label.dirty_begin) * sizeof(TextVertex),
+                            (label.dirty_end - label.dirty_begin) * sizeof(TextVertex),
+                            &label.vertices[label.dirty_begin]);
+            label.dirty_begin = label.dirty_end = 0;
+        }
+        g_TextLabelFirsts.push_back((GLint)label.gpu_first);
+        g_TextLabelCounts.push_back((GLsizei)label.vertices.size());
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Desenha todo o texto do quadro: os labels, com um único
+// glMultiDrawArrays(), e o texto acumulado por TextRendering_PrintString(),
+// com um único glDrawArrays(). Deve ser chamada uma vez por quadro, depois
+// de todas as chamadas de TextRendering_PrintString() e
+// TextRendering_DrawLabel().
+void TextRendering_Flush()
+{
+    if (g_TextVertices.empty() && g_TextLabelsToDraw.empty())
+        return;
+
+    if (!g_TextLabelsToDraw.empty())
+        UploadLabels();
+
+    if (!g_TextVertices.empty())
+    {
         glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, 24 * sizeof(float), data);
+        if (g_TextVertices.size() > g_TextVBOCapacity)
+            g_TextVBOCapacity = g_TextVertices.capacity();
+
+        // Descartamos o conteúdo anterior do VBO ("orphaning") antes de
+        // escrever, para que o driver não precise esperar a GPU terminar de
+        // ler o texto do quadro anterior.
+        glBufferData(GL_ARRAY_BUFFER, g_TextVBOCapacity * sizeof(TextVertex), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, g_TextVertices.size() * sizeof(TextVertex), g_TextVertices.data());
         glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
 
-        glUseProgram(textprogram_id);
-        glBindVertexArray(textVAO);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glDepthFunc(GL_ALWAYS);
 
-        glBindVertexArray(0);
-        glUseProgram(0);
-        glDepthFunc(GL_LESS);
+    glUseProgram(textprogram_id);
 
-        glDisable(GL_BLEND);
+    if (!g_TextLabelsToDraw.empty())
+    {
+        glBindVertexArray(textLabelVAO);
+        glMultiDrawArrays(GL_TRIANGLES, g_TextLabelFirsts.data(), g_TextLabelCounts.data(), (GLsizei)g_TextLabelFirsts.size());
+    }
 
-        x += (glyph->advance_x * sx);
+    if (!g_TextVertices.empty())
+    {
+        glBindVertexArray(textVAO);
+        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)g_TextVertices.size());
     }
+
+    glBindVertexArray(0);
+    glUseProgram(0);
+    glDepthFunc(GL_LESS);
+
+    glDisable(GL_BLEND);
+
+    g_TextVertices.clear();
+    g_TextLabelsToDraw.clear();
 }
 
 float TextRendering_LineHeight(GLFWwindow* window)
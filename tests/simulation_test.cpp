@@ -0,0 +1,175 @@
+// Testes de regressão da simulação da corrida (veja "simulation.h"): o carro
+// do jogador é dirigido contra os obstáculos da pista com Simulation_Step(),
+// sem janela nem OpenGL, e o resultado é comparado com o esperado.
+//
+// Compilado como o alvo "simulation_test" do CMake e executado pelo ctest.
+// Uso (a partir de bin/Linux, como o executável principal):
+//
+//     ./simulation_test [--data DIRETÓRIO]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+
+#include <glm/glm.hpp>
+
+#include "collisions.h"
+#include "mesh.h"
+#include "simulation.h"
+
+static int g_Failures = 0;
+
+#define EXPECT(condition, ...)                                          \
+    do {                                                                \
+        if ( !(condition) )                                             \
+        {                                                               \
+            fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__);        \
+            fprintf(stderr, __VA_ARGS__);                               \
+            fprintf(stderr, "\n");                                      \
+            g_Failures += 1;                                            \
+        }                                                               \
+    } while (0)
+
+// Monta a pista como em headless.cpp, a partir dos arquivos ".obj" do jogo
+static void BuildTrack(const std::string& data_dir, TrackColliders* track)
+{
+    std::map<std::string, MeshShape> shapes;
+    const char* filenames[] = { "track.obj", "car.obj", "wall.obj", "guardRail.obj", "car_pc.obj" };
+    for (size_t i = 0; i < sizeof(filenames) / sizeof(filenames[0]); ++i)
+    {
+        MeshData mesh;
+        LoadMeshData((data_dir + "/" + filenames[i]).c_str(), &mesh, i == 0 ? TRACK_PLANE_SCALE : 1.0f);
+        for (size_t s = 0; s < mesh.shapes.size(); ++s)
+            shapes[mesh.shapes[s].name] = mesh.shapes[s];
+    }
+
+    Simulation_BuildTrack(track,
+        [&shapes](const char* name, glm::vec3* bbox_min, glm::vec3* bbox_max) {
+            std::map<std::string, MeshShape>::const_iterator it = shapes.find(name);
+            *bbox_min = it != shapes.end() ? it->second.bbox_min : glm::vec3(0.0f);
+            *bbox_max = it != shapes.end() ? it->second.bbox_max : glm::vec3(0.0f);
+        },
+        glm::vec3(0.0f, 0.0f, 0.0f));
+}
+
+// Maior penetração horizontal do carro do jogador nos obstáculos da grade
+static float MaxPenetration(const SimulationState& state, const TrackColliders& track, const StaticColliderGrid& grid)
+{
+    OrientedBoundingBox car = ComputeCarOBB(state.car_pos, state.car_yaw, track.car_bbox_min, track.car_bbox_max);
+    float max_depth = 0.0f;
+    for (size_t i = 0; i < grid.boxes.size(); ++i)
+    {
+        CollisionContact contact;
+        if ( CheckOBBAABBCollisionXZ(car, grid.boxes[i], &contact) )
+            max_depth = std::max(max_depth, contact.depth);
+    }
+    return max_depth;
+}
+
+// Acelera em linha reta contra os postes da chegada (z = 405). O carro deve
+// parar antes deles e ficar parado, sem ser erguido pelo contato nem
+// atravessá-los aos poucos.
+static void TestDriveIntoFinishWall(const TrackColliders& track)
+{
+    SimulationState state;
+    Simulation_Init(&state, track);
+    state.car_pos.x = 0.0f; // Alinhado com o poste em x = 0
+    Simulation_ChooseDifficulty(&state, 0);
+
+    float wall_min_z = track.wall_grid.boxes[0].min.z;
+    for (size_t i = 1; i < track.wall_grid.boxes.size(); ++i)
+        wall_min_z = std::min(wall_min_z, track.wall_grid.boxes[i].min.z);
+
+    float ground_y  = -1.0f;
+    float max_front = -1e9f;
+    float max_depth = 0.0f;
+    bool  stopped   = false;
+    const int steps = 60 * SIMULATION_HZ;
+    for (int step = 0; step < steps; ++step)
+    {
+        Simulation_Step(&state, SIMULATION_KEY_W, track, SIMULATION_TIMESTEP);
+
+        if ( state.race_started && ground_y < 0.0f )
+            ground_y = state.car_pos.y;
+
+        max_front = std::max(max_front, state.car_pos.z + track.car_bbox_max.z);
+        max_depth = std::max(max_depth, MaxPenetration(state, track, track.wall_grid));
+        if ( state.car_pos.z > 400.0f && state.car_speed == 0.0f )
+            stopped = true;
+    }
+
+    EXPECT(stopped, "o carro não parou nos postes da chegada (z = %.3f)", state.car_pos.z);
+    EXPECT(max_front <= wall_min_z + 0.01f,
+           "o carro atravessou os postes da chegada (frente em z = %.3f, postes em z = %.3f)", max_front, wall_min_z);
+    EXPECT(max_depth <= 0.01f, "penetração de %.4f nos postes da chegada", max_depth);
+    EXPECT(std::abs(state.car_pos.y - ground_y) < 1e-3f,
+           "o contato mudou a altura do carro (%.4f, no chão %.4f)", state.car_pos.y, ground_y);
+}
+
+// Acelera de lado (na direção +x) contra o primeiro guard rail da esquerda,
+// em (5, z = -320). Os guard rails são postes separados por 5 unidades; o
+// carro está alinhado com um deles e deve parar encostado nele.
+static void TestDriveIntoGuardRail(const TrackColliders& track)
+{
+    SimulationState state;
+    Simulation_Init(&state, track);
+    state.car_pos.z = -320.0f;
+    state.car_yaw   = 1.5707963f;
+    Simulation_ChooseDifficulty(&state, 0);
+
+    const BoundingBox& guard_rail = track.guardRail_grid.boxes[track.guardRail_grid.boxes.size() / 2];
+    EXPECT(guard_rail.min.x > 0.0f && guard_rail.min.z < -320.0f && guard_rail.max.z > -320.0f,
+           "guard rail inesperado em (%.3f, %.3f)", guard_rail.min.x, guard_rail.min.z);
+
+    float max_front = -1e9f;
+    float max_depth = 0.0f;
+    const int steps = 20 * SIMULATION_HZ;
+    for (int step = 0; step < steps; ++step)
+    {
+        Simulation_Step(&state, SIMULATION_KEY_W, track, SIMULATION_TIMESTEP);
+
+        max_front = std::max(max_front, state.car_pos.x + track.car_bbox_max.z);
+        max_depth = std::max(max_depth, MaxPenetration(state, track, track.guardRail_grid));
+    }
+
+    // Encostado, o carro ainda acelera por um passo antes de cada contato
+    EXPECT(state.race_started && state.car_speed < 0.1f,
+           "o carro não parou no guard rail (x = %.3f, velocidade %.3f)", state.car_pos.x, state.car_speed);
+    EXPECT(max_front <= guard_rail.min.x + 0.01f,
+           "o carro atravessou o guard rail (frente em x = %.3f, guard rail em x = %.3f)", max_front, guard_rail.min.x);
+    EXPECT(max_depth <= 0.01f, "penetração de %.4f nos guard rails", max_depth);
+}
+
+int main(int argc, char* argv[])
+{
+    std::string data_dir = "../data";
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if ( strcmp(argv[i], "--data") == 0 && i + 1 < argc )
+            data_dir = argv[++i];
+        else
+        {
+            fprintf(stderr, "Usage: %s [--data DIR]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    TrackColliders track;
+    BuildTrack(data_dir, &track);
+
+    TestDriveIntoFinishWall(track);
+    TestDriveIntoGuardRail(track);
+
+    if ( g_Failures > 0 )
+    {
+        fprintf(stderr, "%d falha(s).\n", g_Failures);
+        return EXIT_FAILURE;
+    }
+    printf("OK.\n");
+    return EXIT_SUCCESS;
+}